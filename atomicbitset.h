@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "bitset.h"
+
+// fixed size bitset that many threads can mark at once, for visited sets and mark phases
+// same layout as bitset_t, atomic_bitset_view hands the words to the single threaded api without copying
+// only uses the public bitset api, BITSET_IMPLEMENTATION has to be defined in one file too (e.g. next to ATOMICBITSET_IMPLEMENTATION)
+
+typedef struct atomic_bitset_t {
+    _Atomic uint64_t* data;
+    size_t count; //in bits
+    size_t cap; //in uint64_ts
+} atomic_bitset_t;
+
+_Static_assert(sizeof(_Atomic uint64_t) == sizeof(uint64_t), "atomic words must match bitset_t words");
+
+void atomic_bitset_init(atomic_bitset_t* abs, size_t nbits);
+void atomic_bitset_destroy(atomic_bitset_t* abs);
+
+// bitset_t over the same words, only use it while no thread is writing
+bitset_t atomic_bitset_view(atomic_bitset_t* abs);
+
+// these work on disjoint word ranges, so callers can split [0, cap) across their own worker threads
+size_t atomic_bitset_count_words(atomic_bitset_t* abs, size_t word_begin, size_t word_end);
+void atomic_bitset_clear_words(atomic_bitset_t* abs, size_t word_begin, size_t word_end);
+// split words across nthreads pthreads, no writers may be running meanwhile
+size_t atomic_bitset_count_parallel(atomic_bitset_t* abs, size_t nthreads);
+void atomic_bitset_clear_parallel(atomic_bitset_t* abs, size_t nthreads);
+
+// relaxed read, may miss bits set concurrently
+static inline int atomic_bitset_get(atomic_bitset_t* abs, size_t index){
+    assert(index < abs->count);
+    return (atomic_load_explicit(&abs->data[_intindex(index)], memory_order_relaxed) >> _valbit(index)) & 1;
+}
+
+// returns previous value, only one thread gets 0 for a given bit
+static inline int atomic_bitset_test_and_set(atomic_bitset_t* abs, size_t index){
+    assert(index < abs->count);
+    _Atomic uint64_t* word = &abs->data[_intindex(index)];
+    uint64_t bit = (uint64_t)1 << _valbit(index);
+    if(atomic_load_explicit(word, memory_order_relaxed) & bit) // already set, skip the locked rmw and keep line shared
+        return 1;
+    return (atomic_fetch_or_explicit(word, bit, memory_order_acq_rel) & bit) != 0;
+}
+
+// returns previous value, only one thread gets 1 for a given bit
+static inline int atomic_bitset_test_and_clear(atomic_bitset_t* abs, size_t index){
+    assert(index < abs->count);
+    _Atomic uint64_t* word = &abs->data[_intindex(index)];
+    uint64_t bit = (uint64_t)1 << _valbit(index);
+    if(!(atomic_load_explicit(word, memory_order_relaxed) & bit))
+        return 0;
+    return (atomic_fetch_and_explicit(word, ~bit, memory_order_acq_rel) & bit) != 0;
+}
+
+#define atomic_bitset_put(abs, index)    ((void)atomic_bitset_test_and_set(abs, index))
+#define atomic_bitset_clean(abs, index)  ((void)atomic_bitset_test_and_clear(abs, index))
+
+
+#ifdef ATOMICBITSET_IMPLEMENTATION
+
+#include <string.h>
+#include <pthread.h>
+
+void atomic_bitset_init(atomic_bitset_t* abs, size_t nbits){
+    abs->count = nbits;
+    abs->cap = _bitset_words(nbits);
+    size_t size = ((abs->cap ? abs->cap : 1) * sizeof(uint64_t) + 63) & ~(size_t)63; // whole cache lines, _atomic_bitset_run splits on them
+    abs->data = (_Atomic uint64_t*)aligned_alloc(64, size);
+    memset((void*)abs->data, 0, size);
+}
+
+void atomic_bitset_destroy(atomic_bitset_t* abs){
+    if(abs == NULL) return;
+    if(abs->data)
+        free((void*)abs->data);
+    abs->data = NULL;
+    abs->count = 0;
+    abs->cap = 0;
+}
+
+bitset_t atomic_bitset_view(atomic_bitset_t* abs){
+    bitset_t bs = {(uint64_t*)abs->data, abs->count, abs->cap};
+    return bs;
+}
+
+size_t atomic_bitset_count_words(atomic_bitset_t* abs, size_t word_begin, size_t word_end){
+    size_t words = _bitset_words(abs->count);
+    if(word_end > words)
+        word_end = words;
+    if(word_begin >= word_end) return 0;
+    size_t nbits = word_end < words ? (word_end - word_begin) << 6 : abs->count - (word_begin << 6);
+    bitset_t part = {(uint64_t*)abs->data + word_begin, nbits, word_end - word_begin};
+    return bitset_count(&part);
+}
+
+void atomic_bitset_clear_words(atomic_bitset_t* abs, size_t word_begin, size_t word_end){
+    if(word_end > abs->cap)
+        word_end = abs->cap;
+    if(word_begin >= word_end) return;
+    memset((void*)(abs->data + word_begin), 0, (word_end - word_begin) * sizeof(uint64_t));
+}
+
+typedef struct _atomic_bitset_job_t {
+    atomic_bitset_t* abs;
+    size_t begin;
+    size_t end;
+    size_t result;
+    int clear;
+    int threaded;
+} _atomic_bitset_job_t;
+
+static void* _atomic_bitset_worker(void* arg){
+    _atomic_bitset_job_t* job = (_atomic_bitset_job_t*)arg;
+    if(job->clear)
+        atomic_bitset_clear_words(job->abs, job->begin, job->end);
+    else
+        job->result = atomic_bitset_count_words(job->abs, job->begin, job->end);
+    return NULL;
+}
+
+// chunks are whole cache lines so threads never share one
+static size_t _atomic_bitset_run(atomic_bitset_t* abs, size_t nthreads, int clear){
+    size_t words = abs->cap;
+    if(nthreads < 1)
+        nthreads = 1;
+    size_t chunk = ((words + nthreads - 1) / nthreads + 7) & ~(size_t)7;
+    _atomic_bitset_job_t* jobs = (_atomic_bitset_job_t*)calloc(nthreads, sizeof(_atomic_bitset_job_t));
+    pthread_t* threads = (pthread_t*)malloc(nthreads * sizeof(pthread_t));
+    for(size_t t = 0; t < nthreads && t * chunk < words; t++){
+        jobs[t] = (_atomic_bitset_job_t){abs, t * chunk, (t + 1) * chunk, 0, clear, 0};
+        if(t == 0) continue; // calling thread does first chunk
+        jobs[t].threaded = pthread_create(&threads[t], NULL, _atomic_bitset_worker, &jobs[t]) == 0;
+        if(!jobs[t].threaded)
+            _atomic_bitset_worker(&jobs[t]);
+    }
+    _atomic_bitset_worker(&jobs[0]);
+    size_t result = 0;
+    for(size_t t = 0; t < nthreads; t++){
+        if(jobs[t].threaded)
+            pthread_join(threads[t], NULL);
+        result += jobs[t].result;
+    }
+    free(threads);
+    free(jobs);
+    return result;
+}
+
+size_t atomic_bitset_count_parallel(atomic_bitset_t* abs, size_t nthreads){
+    if(abs == NULL || abs->count == 0) return 0;
+    return _atomic_bitset_run(abs, nthreads, 0);
+}
+
+void atomic_bitset_clear_parallel(atomic_bitset_t* abs, size_t nthreads){
+    if(abs == NULL || abs->cap == 0) return;
+    _atomic_bitset_run(abs, nthreads, 1);
+}
+
+#endif
@@ -1,117 +1,257 @@
-#pragma once
-
-#include <stdlib.h>
-#include <stdint.h>
-#include <string.h>
-
-typedef struct awarearray_t {
-    void* data;
-    size_t elem_size;
-    size_t count;
-    size_t cap;
-    size_t* availables; // its stack thats stored end to start
-} awarearray_t;
-
-
-#define _AWARR_DEFAULT_CAP  32
-
-
-#define rtolvalue(val) ((struct { typeof(val) _; }){val})
-
-
-#define awarr_as(arr, type)  ((type*)(arr)->data)
-#define awarr_get(arr, index, type)  (awarr_as(arr, type)[index])
-#define awarr_getp(arr, index, type)  (awarr_as(arr, type) + (index))
-#define awarr_getraw(arr, index)  ((arr)->data + (index) * (arr)->elem_size)
-
-#define awarr_push(arr, lval)  _awarr_push(arr, (void*)&lval);
-#define awarr_push_rval(arr, rval)  _awarr_push(arr, (void*)&rtolvalue(rval));
-void _awarr_push(awarearray_t* arr, void* elem);
-void awarr_delete(awarearray_t* arr, size_t index);
-
-//awarearray_t* awarr_new(size_t elem_size);
-//awarearray_t* awarr_new_cap(size_t elem_size, size_t min_cap);
-void awarr_init(awarearray_t* arr, size_t elem_size);
-void awarr_init_cap(awarearray_t* arr, size_t elem_size, size_t min_cap);
-void awarr_expand(awarearray_t* arr, size_t min_cap);
-void awarr_free(awarearray_t* arr);
-
-
-#ifdef _AWARR_IMPLEMENTATION_
-
-void awarr_expand(awarearray_t* arr, size_t min_cap){
-    if(!arr || min_cap < 1) return;
-    size_t cap = arr->cap;
-    if(cap >= min_cap){
-        return;
-    }
-    size_t availables_index = cap;
-
-    cap = (cap < 1 ? 1 : cap);
-    size_t growth = (min_cap - 1) / cap + 1;
-    size_t new_cap = growth * cap;
-
-    arr->cap = new_cap;
-
-    arr->data = realloc(arr->data, new_cap * arr->elem_size);
-    arr->availables = (size_t*)realloc(arr->availables, new_cap * sizeof(size_t));
-
-    // fill missing available indexes
-    for(; availables_index < new_cap; availables_index++){
-        arr->availables[availables_index] = availables_index;
-    }
-}
-
-// awarearray_t* awarr_new(size_t elem_size){
-//     return awarr_new_cap(elem_size, _AWARR_DEFAULT_CAP);
-// }
-// awarearray_t* awarr_new_cap(size_t elem_size, size_t min_cap){
-//     awarearray_t* arr = (awarearray_t*)malloc(sizeof(awarearray_t));
-//     arr->count = 0;
-//     arr->cap = 0;
-//     arr->elem_size = elem_size;
-//     awarr_expand(arr, min_cap);
-//     return arr;
-// }
-
-void awarr_init(awarearray_t* arr, size_t elem_size){
-    awarr_init_cap(arr, elem_size, _AWARR_DEFAULT_CAP)
-}
-void awarr_init_cap(awarearray_t* arr, size_t elem_size, size_t min_cap){
-    arr->count = 0;
-    arr->cap = 0;
-    arr->elem_size = elem_size;
-    awarr_expand(arr, min_cap);
-}
-
-void _awarr_push(awarearray_t* arr, void* elem){
-    if(!arr || !elem) return;
-    size_t count = arr->count;
-    if(count >= arr->cap){
-        awarr_expand(arr, arr->cap * 2);
-    }
-    size_t available_index = count;
-    size_t index = arr->availables[available_index]; 
-
-    //memcpy(arr->data + index * arr->elem_size, elem, arr->elem_size);
-    memcpy(awarr_getraw(arr, index), elem, arr->elem_size);
-    arr->count++;
-}
-
-void awarr_delete(awarearray_t* arr, size_t index){
-    if(!arr || arr->count <= 0) return;
-    arr->count--;
-    arr->availables[arr->count] = index;
-}
-
-void awarr_free(awarearray_t* arr){
-    if(!arr) return;
-    if(arr->data)
-        free(arr->data);
-    if(arr->availables)
-        free(arr->availables);
-    //free(arr);
-}
-
-#endif
-
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// define AWARR_CHUNKED to store elements in fixed size pages that never move,
+// so pointers into the array stay valid when it grows
+#ifdef AWARR_CHUNKED
+#ifndef AWARR_PAGE_SHIFT
+#define AWARR_PAGE_SHIFT 10 // slots per page = 1 << shift, must be >= 6
+#endif
+#endif
+
+typedef struct awarearray_t {
+#ifdef AWARR_CHUNKED
+    void** pages; // each page is [occupied words][availables][data], page table is the only thing realloced
+#else
+    void* data;
+#endif
+    size_t elem_size;
+    size_t count;
+    size_t cap;
+#ifndef AWARR_CHUNKED
+    size_t* availables; // its stack thats stored end to start
+    uint64_t* occupied; // bit per slot, set while slot holds a live element
+#endif
+} awarearray_t;
+
+
+#define _AWARR_DEFAULT_CAP  32
+#define AWARR_NO_INDEX  SIZE_MAX
+
+
+#define rtolvalue(val) ((struct { typeof(val) _; }){val})
+
+
+#ifdef AWARR_CHUNKED
+#define _AWARR_PAGE_CAP  ((size_t)1 << AWARR_PAGE_SHIFT)
+#define _AWARR_PAGE_MASK  (_AWARR_PAGE_CAP - 1)
+#define _AWARR_PAGE_AVAIL_OFFSET  ((_AWARR_PAGE_CAP >> 6) * sizeof(uint64_t))
+#define _AWARR_PAGE_DATA_OFFSET  (_AWARR_PAGE_AVAIL_OFFSET + _AWARR_PAGE_CAP * sizeof(size_t))
+
+#define _awarr_page(arr, index)  ((char*)(arr)->pages[(index) >> AWARR_PAGE_SHIFT])
+#define _awarr_occword(arr, w)  (((uint64_t*)(arr)->pages[(w) >> (AWARR_PAGE_SHIFT - 6)])[(w) & (_AWARR_PAGE_MASK >> 6)])
+#define _awarr_avail(arr, k)  (((size_t*)(_awarr_page(arr, k) + _AWARR_PAGE_AVAIL_OFFSET))[(k) & _AWARR_PAGE_MASK])
+
+#define awarr_getraw(arr, index)  (_awarr_page(arr, index) + _AWARR_PAGE_DATA_OFFSET + ((index) & _AWARR_PAGE_MASK) * (arr)->elem_size)
+#define awarr_get(arr, index, type)  (*(type*)awarr_getraw(arr, index))
+#define awarr_getp(arr, index, type)  ((type*)awarr_getraw(arr, index))
+#else
+#define _awarr_occword(arr, w)  ((arr)->occupied[w])
+#define _awarr_avail(arr, k)  ((arr)->availables[k])
+
+#define awarr_as(arr, type)  ((type*)(arr)->data)
+#define awarr_get(arr, index, type)  (awarr_as(arr, type)[index])
+#define awarr_getp(arr, index, type)  (awarr_as(arr, type) + (index))
+#define awarr_getraw(arr, index)  ((arr)->data + (index) * (arr)->elem_size)
+#endif
+
+#define awarr_is_live(arr, index)  ((_awarr_occword(arr, (index) >> 6) >> ((index) & 63)) & 1)
+
+// iterates only over live slots, skipping whole empty words of occupied
+#define awarr_foreach_live(arr, i) \
+    for(size_t i = awarr_next_live(arr, 0); i < (arr)->cap; i = awarr_next_live(arr, i + 1))
+
+#define awarr_push(arr, lval)  _awarr_push(arr, (void*)&lval);
+#define awarr_push_rval(arr, rval)  _awarr_push(arr, (void*)&rtolvalue(rval));
+// returns index of slot elem was put into
+size_t _awarr_push(awarearray_t* arr, void* elem);
+void awarr_delete(awarearray_t* arr, size_t index);
+
+// first live index >= from, cap if none
+size_t awarr_next_live(awarearray_t* arr, size_t from);
+// moves live elements to [0, count), returns malloced remap of cap entries: remap[old] = new or AWARR_NO_INDEX for holes
+size_t* awarr_compact(awarearray_t* arr);
+
+//awarearray_t* awarr_new(size_t elem_size);
+//awarearray_t* awarr_new_cap(size_t elem_size, size_t min_cap);
+void awarr_init(awarearray_t* arr, size_t elem_size);
+void awarr_init_cap(awarearray_t* arr, size_t elem_size, size_t min_cap);
+void awarr_expand(awarearray_t* arr, size_t min_cap);
+void awarr_free(awarearray_t* arr);
+
+
+#ifdef _AWARR_IMPLEMENTATION_
+
+#ifdef AWARR_CHUNKED
+// grows by whole pages, existing pages stay where they are
+void awarr_expand(awarearray_t* arr, size_t min_cap){
+    if(!arr || min_cap < 1) return;
+    size_t cap = arr->cap;
+    if(cap >= min_cap){
+        return;
+    }
+    size_t page_count = cap >> AWARR_PAGE_SHIFT;
+    size_t new_page_count = ((min_cap - 1) >> AWARR_PAGE_SHIFT) + 1;
+    size_t new_cap = new_page_count << AWARR_PAGE_SHIFT;
+
+    arr->pages = (void**)realloc(arr->pages, new_page_count * sizeof(void*));
+    for(size_t p = page_count; p < new_page_count; p++){
+        arr->pages[p] = malloc(_AWARR_PAGE_DATA_OFFSET + _AWARR_PAGE_CAP * arr->elem_size);
+        memset(arr->pages[p], 0, _AWARR_PAGE_AVAIL_OFFSET);
+    }
+    arr->cap = new_cap;
+
+    // fill missing available indexes
+    for(size_t availables_index = cap; availables_index < new_cap; availables_index++){
+        _awarr_avail(arr, availables_index) = availables_index;
+    }
+}
+#define _AWARR_GROW_CAP(arr)  ((arr)->count + 1) // one page at a time
+#else
+void awarr_expand(awarearray_t* arr, size_t min_cap){
+    if(!arr || min_cap < 1) return;
+    size_t cap = arr->cap;
+    if(cap >= min_cap){
+        return;
+    }
+    size_t availables_index = cap;
+    size_t old_words = (cap + 63) >> 6;
+
+    cap = (cap < 1 ? 1 : cap);
+    size_t growth = (min_cap - 1) / cap + 1;
+    size_t new_cap = growth * cap;
+    size_t new_words = (new_cap + 63) >> 6;
+
+    arr->cap = new_cap;
+
+    arr->data = realloc(arr->data, new_cap * arr->elem_size);
+    arr->availables = (size_t*)realloc(arr->availables, new_cap * sizeof(size_t));
+    arr->occupied = (uint64_t*)realloc(arr->occupied, new_words * sizeof(uint64_t));
+    memset(arr->occupied + old_words, 0, (new_words - old_words) * sizeof(uint64_t)); // bits past old cap in last old word are already 0
+
+    // fill missing available indexes
+    for(; availables_index < new_cap; availables_index++){
+        arr->availables[availables_index] = availables_index;
+    }
+}
+#define _AWARR_GROW_CAP(arr)  ((arr)->cap * 2)
+#endif
+
+// awarearray_t* awarr_new(size_t elem_size){
+//     return awarr_new_cap(elem_size, _AWARR_DEFAULT_CAP);
+// }
+// awarearray_t* awarr_new_cap(size_t elem_size, size_t min_cap){
+//     awarearray_t* arr = (awarearray_t*)malloc(sizeof(awarearray_t));
+//     arr->count = 0;
+//     arr->cap = 0;
+//     arr->elem_size = elem_size;
+//     awarr_expand(arr, min_cap);
+//     return arr;
+// }
+
+void awarr_init(awarearray_t* arr, size_t elem_size){
+    awarr_init_cap(arr, elem_size, _AWARR_DEFAULT_CAP);
+}
+void awarr_init_cap(awarearray_t* arr, size_t elem_size, size_t min_cap){
+#ifdef AWARR_CHUNKED
+    arr->pages = NULL;
+#else
+    arr->data = NULL;
+    arr->availables = NULL;
+    arr->occupied = NULL;
+#endif
+    arr->count = 0;
+    arr->cap = 0;
+    arr->elem_size = elem_size;
+    awarr_expand(arr, min_cap);
+}
+
+size_t _awarr_push(awarearray_t* arr, void* elem){
+    if(!arr || !elem) return AWARR_NO_INDEX;
+    size_t count = arr->count;
+    if(count >= arr->cap){
+        awarr_expand(arr, _AWARR_GROW_CAP(arr));
+    }
+    size_t available_index = count;
+    size_t index = _awarr_avail(arr, available_index);
+
+    //memcpy(arr->data + index * arr->elem_size, elem, arr->elem_size);
+    memcpy(awarr_getraw(arr, index), elem, arr->elem_size);
+    _awarr_occword(arr, index >> 6) |= (uint64_t)1 << (index & 63);
+    arr->count++;
+    return index;
+}
+
+void awarr_delete(awarearray_t* arr, size_t index){
+    if(!arr || arr->count <= 0 || index >= arr->cap) return;
+    if(!awarr_is_live(arr, index)) return; // already a hole, dont push it on stack twice
+    _awarr_occword(arr, index >> 6) &= ~((uint64_t)1 << (index & 63));
+    arr->count--;
+    _awarr_avail(arr, arr->count) = index;
+}
+
+size_t awarr_next_live(awarearray_t* arr, size_t from){
+    if(!arr || from >= arr->cap) return arr ? arr->cap : 0;
+    size_t words = (arr->cap + 63) >> 6;
+    size_t w = from >> 6;
+    uint64_t bits = _awarr_occword(arr, w) & (~(uint64_t)0 << (from & 63)); // drop bits before from
+    while(bits == 0){
+        if(++w >= words) return arr->cap;
+        bits = _awarr_occword(arr, w);
+    }
+    return (w << 6) + __builtin_ctzll(bits);
+}
+
+size_t* awarr_compact(awarearray_t* arr){
+    if(!arr || arr->cap == 0) return NULL;
+    size_t cap = arr->cap;
+    size_t* remap = (size_t*)malloc(cap * sizeof(size_t));
+    for(size_t i = 0; i < cap; i++){
+        remap[i] = awarr_is_live(arr, i) ? i : AWARR_NO_INDEX;
+    }
+
+    // fill holes from the front with live elements from the back, so only elements past count move
+    size_t lo = 0;
+    size_t hi = cap;
+    while(1){
+        while(lo < hi && awarr_is_live(arr, lo)) lo++;
+        while(hi > lo && !awarr_is_live(arr, hi - 1)) hi--;
+        if(hi <= lo + 1) break;
+        hi--;
+        memcpy(awarr_getraw(arr, lo), awarr_getraw(arr, hi), arr->elem_size);
+        _awarr_occword(arr, lo >> 6) |= (uint64_t)1 << (lo & 63);
+        _awarr_occword(arr, hi >> 6) &= ~((uint64_t)1 << (hi & 63));
+        remap[hi] = lo;
+        lo++;
+    }
+
+    for(size_t i = arr->count; i < cap; i++){
+        _awarr_avail(arr, i) = i;
+    }
+    return remap;
+}
+
+void awarr_free(awarearray_t* arr){
+    if(!arr) return;
+#ifdef AWARR_CHUNKED
+    for(size_t p = 0; p < (arr->cap >> AWARR_PAGE_SHIFT); p++){
+        free(arr->pages[p]);
+    }
+    if(arr->pages)
+        free(arr->pages);
+#else
+    if(arr->data)
+        free(arr->data);
+    if(arr->availables)
+        free(arr->availables);
+    if(arr->occupied)
+        free(arr->occupied);
+#endif
+    //free(arr);
+}
+
+#endif
+
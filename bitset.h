@@ -1,159 +1,792 @@
-#pragma once
-
-#include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
-#include <assert.h>
-
-typedef struct bitset_t {
-    uint64_t* data;
-    size_t count; //in bits
-    size_t cap; //in uint64_ts
-} bitfield_t;
-
-
-void bitset_init(bitset_t* bs){
-    bs->data = NULL;
-    bs->count = 0;
-    bs->cap = 0;
-}
-void bitset_clear(bitset_t* bs){
-    bs->count = 0;
-    if(bs->data)
-        memset(bs->data, 0, bs->cap * sizeof(uint64_t));
-}
-void bitset_destroy(bitset_t* bs){
-    bs->count = 0;
-    bs->cap = 0;
-    if(bs->data)
-        free(bs->data);
-}
-
-#define _BITSET_INIT_CAP 1
-
-#define _intindex(index) (index >> 6)
-#define _valbit(index) (index & ((1 << 6) - 1))
-
-static void bitset_maybe_expand(bitset_t* bs){
-    if(bs->count >= (bs->cap << 6)){
-        if(bs->cap == 0)
-            bs->cap = _BITSET_INIT_CAP;
-        bs->cap <<= 1;
-        if(bs->data)
-            free(bs->data);
-        bs->data = (uint64_t*)calloc(bs->cap, sizeof(uint64_t*));
-    }
-}
-
-void bitset_push(bitset_t* bs, int val){
-    if(bs == NULL) return;
-    bitset_maybe_expand(bs);
-
-    size_t intindex = _intindex(bs->count);
-    size_t valbit = _valbit(bs->count);
-    if(valbit == (1 << 6) - 1){
-        intindex++;
-        valbit = 0;
-    }
-    bs->data[intindex] |= !!val << valbit;
-    bs->count++;
-}
-
-int bitset_get(bitset_t* bs, size_t index){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    size_t intindex = _intindex(index);
-    size_t valbit = _valbit(index);
-    return (bs->data[intindex] >> valbit) & 1;
-}
-int bitset_peek(bitset_t* bs){
-    if(bs == NULL || bs->count == 0) return 0;
-
-    return bitset_get(bs, bs->count - 1);
-}
-
-int bitset_clean(bitset_t* bs, size_t index){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    size_t intindex = _intindex(bs->count);
-    size_t valbit = _valbit(bs->count);
-
-    bs->data[intindex] &= ~(1 << valbit);
-    return (bs->data[intindex] >> valbit) & 1;
-}
-int bitset_put(bitset_t* bs, size_t index){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    size_t intindex = _intindex(bs->count);
-    size_t valbit = _valbit(bs->count);
-
-    bs->data[intindex] |= 1 << valbit;
-    return (bs->data[intindex] >> valbit) & 1;
-}
-int bitset_set(bitset_t* bs, size_t index, int val){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    size_t intindex = _intindex(bs->count);
-    size_t valbit = _valbit(bs->count);
-
-    bs->data[intindex] = (bs->data[intindex] & ~(1 << valbit)) | !!val << valbit;
-    return (bs->data[intindex] >> valbit) & 1;
-}
-int bitset_toggle(bitset_t* bs, size_t index){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    size_t intindex = _intindex(bs->count);
-    size_t valbit = _valbit(bs->count);
-
-    bs->data[intindex] ^= 1 << valbit;
-    return (bs->data[intindex] >> valbit) & 1;
-}
-
-int bitset_erase(bitset_t* bs, size_t index){
-    if(bs == NULL || bs->count == 0) return 0;
-    assert(index < bs->count);
-
-    bs->count--;
-    return bitset_get(bs, index);
-}
-int bitset_pop(bitset_t* bs){
-    if(bs == NULL || bs->count == 0) return 0;
-
-    return bitset_erase(bs, bs->count - 1);
-}
-
-void bitset_insert(bitset_t* bs, size_t index, int val){
-    if(bs == NULL) return;
-    assert(index <= bs->count);
-    bitset_maybe_expand(bs);
-
-    //if(index >= bs->count){
-    //    bitset_push(bs, val);
-    //    return;
-    //}
-
-    size_t intindex = _intindex(index);
-    size_t valbit = _valbit(index);
-    
-    size_t maxintindex = _intindex(bs->count);
-    size_t maxvalbit = _valbit(bs->count);
-    if(maxvalbit == (1 << 6) - 1){
-        maxintindex++;
-        maxvalbit = 0;
-    }
-
-    while(maxintindex > intindex){
-        bs->data[maxintindex] = (bs->data[maxintindex] << 1) | ((bs->data[maxintindex - 1] >> 63) & 1);
-        maxintindex--;
-    }
-
-    bs->data[intindex] = (bs->data[intindex] << 1) | 
-            (bs->data[intindex] & ((1 << valbit) - 1)) | 
-            (!!val << valbit); //part left to bit + part right to bit + bit
-}
-
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+typedef struct bitset_t {
+    uint64_t* data;
+    size_t count; //in bits
+    size_t cap; //in uint64_ts
+} bitset_t;
+
+void bitset_init(bitset_t* bs);
+void bitset_clear(bitset_t* bs);
+void bitset_destroy(bitset_t* bs);
+// makes room for nbits without changing count, keeps contents and zeroes new words
+void bitset_reserve(bitset_t* bs, size_t nbits);
+// changes count, new bits are 0
+void bitset_resize(bitset_t* bs, size_t nbits);
+void bitset_set_range(bitset_t* bs, size_t index, size_t n);
+void bitset_clear_range(bitset_t* bs, size_t index, size_t n);
+// appends first nbits of src, a word at a time
+void bitset_append_bits(bitset_t* bs, const uint64_t* src, size_t nbits);
+// initializes bs with a copy of first nbits of words
+void bitset_from_words(bitset_t* bs, const uint64_t* words, size_t nbits);
+void bitset_push(bitset_t* bs, int val);
+int bitset_get(bitset_t* bs, size_t index);
+int bitset_peek(bitset_t* bs);
+// clean/put/set/toggle return the new bit
+int bitset_clean(bitset_t* bs, size_t index);
+int bitset_put(bitset_t* bs, size_t index);
+int bitset_set(bitset_t* bs, size_t index, int val);
+int bitset_toggle(bitset_t* bs, size_t index);
+// shifts bits [index, count) up by nbits and writes val into the gap, whole word funnel shifts so O(count / 64)
+void bitset_insert_bits(bitset_t* bs, size_t index, size_t nbits, int val);
+// removes bits [index, index + nbits), later bits move down
+void bitset_erase_range(bitset_t* bs, size_t index, size_t nbits);
+// returns erased bit
+int bitset_erase(bitset_t* bs, size_t index);
+int bitset_pop(bitset_t* bs);
+void bitset_insert(bitset_t* bs, size_t index, int val);
+
+
+// word-parallel bulk operations
+// binary ops need a->count == b->count, dst may be a or b (in place) or another bitset that gets resized to fit
+
+void bitset_and(bitset_t* dst, const bitset_t* a, const bitset_t* b);
+void bitset_or(bitset_t* dst, const bitset_t* a, const bitset_t* b);
+void bitset_xor(bitset_t* dst, const bitset_t* a, const bitset_t* b);
+// a & ~b
+void bitset_andnot(bitset_t* dst, const bitset_t* a, const bitset_t* b);
+void bitset_not(bitset_t* dst, const bitset_t* a);
+// number of set bits
+size_t bitset_count(const bitset_t* bs);
+int bitset_any(const bitset_t* bs);
+int bitset_none(const bitset_t* bs);
+int bitset_all(const bitset_t* bs);
+
+#define _intindex(index) ((index) >> 6)
+#define _valbit(index) ((index) & ((1 << 6) - 1))
+#define _bitset_words(count) (((count) + 63) >> 6)
+// valid bits of last word, bits past count may be stale after pop/erase so bulk ops mask them out
+#define _bitset_tail_mask(count) (((count) & 63) ? ((uint64_t)1 << ((count) & 63)) - 1 : ~(uint64_t)0)
+
+
+// set bit search, from is inclusive, returns count if nothing found
+
+size_t bitset_find_first(const bitset_t* bs);
+size_t bitset_find_next(const bitset_t* bs, size_t from);
+size_t bitset_find_first_zero(const bitset_t* bs);
+size_t bitset_find_next_zero(const bitset_t* bs, size_t from);
+
+// visits set bits in increasing order, skipping zero words
+#define bitset_foreach_set(bs, i) \
+    for(size_t i = bitset_find_first(bs); i < (bs)->count; i = bitset_find_next(bs, i + 1))
+
+
+// rank/select index for a bitset that no longer changes
+// rank counts from per 65536 bit superblock and per 512 bit block tables (~3% of bitset size),
+// select narrows down to a block via samples of every 4096th set bit, then binary searches blocks
+
+typedef struct bitset_rank_index_t {
+    const bitset_t* bs;
+    uint64_t* supers; // set bits before each superblock
+    uint16_t* blocks; // set bits before each block, relative to its superblock
+    uint32_t* samples; // block holding each 4096th set bit
+    size_t nblocks;
+    size_t ones; // total set bits
+} bitset_rank_index_t;
+
+void bitset_rank_index_build(bitset_rank_index_t* ri, const bitset_t* bs);
+void bitset_rank_index_destroy(bitset_rank_index_t* ri);
+// set bits in [0, i), i <= count
+size_t bitset_rank(const bitset_rank_index_t* ri, size_t i);
+// index of k-th set bit counting from 0, count if k >= ones
+size_t bitset_select(const bitset_rank_index_t* ri, size_t k);
+
+
+#ifdef BITSET_IMPLEMENTATION
+
+void bitset_init(bitset_t* bs){
+    bs->data = NULL;
+    bs->count = 0;
+    bs->cap = 0;
+}
+void bitset_clear(bitset_t* bs){
+    bs->count = 0;
+    if(bs->data)
+        memset(bs->data, 0, bs->cap * sizeof(uint64_t));
+}
+void bitset_destroy(bitset_t* bs){
+    bs->count = 0;
+    bs->cap = 0;
+    if(bs->data)
+        free(bs->data);
+    bs->data = NULL;
+}
+
+#define _BITSET_INIT_CAP 1
+
+void bitset_reserve(bitset_t* bs, size_t nbits){
+    if(bs == NULL) return;
+    size_t words = (nbits + 63) >> 6;
+    if(bs->cap >= words) return;
+    bs->data = (uint64_t*)realloc(bs->data, words * sizeof(uint64_t));
+    memset(bs->data + bs->cap, 0, (words - bs->cap) * sizeof(uint64_t));
+    bs->cap = words;
+}
+
+// grows geometrically so repeated appends stay amortized O(1) per word
+static void bitset_maybe_expand_to(bitset_t* bs, size_t nbits){
+    if(nbits <= (bs->cap << 6)) return;
+    size_t cap_bits = bs->cap ? bs->cap << 7 : _BITSET_INIT_CAP << 6;
+    bitset_reserve(bs, nbits > cap_bits ? nbits : cap_bits);
+}
+static void bitset_maybe_expand(bitset_t* bs){
+    bitset_maybe_expand_to(bs, bs->count + 1);
+}
+
+// writes val to bits [index, index + n) with masked whole word writes, no bounds check against count
+static void _bitset_fill(bitset_t* bs, size_t index, size_t n, int val){
+    if(n == 0) return;
+    size_t end = index + n;
+    size_t w = _intindex(index);
+    size_t wend = _intindex(end - 1);
+    uint64_t first = ~(uint64_t)0 << _valbit(index);
+    uint64_t last = ~(uint64_t)0 >> (63 - _valbit(end - 1));
+    uint64_t fill = val ? ~(uint64_t)0 : 0;
+    if(w == wend){
+        first &= last;
+        bs->data[w] = (bs->data[w] & ~first) | (fill & first);
+        return;
+    }
+    bs->data[w] = (bs->data[w] & ~first) | (fill & first);
+    if(wend > w + 1)
+        memset(bs->data + w + 1, val ? 0xff : 0, (wend - w - 1) * sizeof(uint64_t));
+    bs->data[wend] = (bs->data[wend] & ~last) | (fill & last);
+}
+
+void bitset_resize(bitset_t* bs, size_t nbits){
+    if(bs == NULL) return;
+    if(nbits > bs->count){
+        bitset_reserve(bs, nbits);
+        _bitset_fill(bs, bs->count, nbits - bs->count, 0); // bits past count may be stale after pop/erase
+    }
+    bs->count = nbits;
+}
+
+void bitset_set_range(bitset_t* bs, size_t index, size_t n){
+    if(bs == NULL) return;
+    assert(index + n <= bs->count);
+    _bitset_fill(bs, index, n, 1);
+}
+void bitset_clear_range(bitset_t* bs, size_t index, size_t n){
+    if(bs == NULL) return;
+    assert(index + n <= bs->count);
+    _bitset_fill(bs, index, n, 0);
+}
+
+void bitset_append_bits(bitset_t* bs, const uint64_t* src, size_t nbits){
+    if(bs == NULL || src == NULL || nbits == 0) return;
+    size_t count = bs->count;
+    size_t total = count + nbits;
+    bitset_maybe_expand_to(bs, total);
+
+    size_t w = _intindex(count);
+    size_t off = _valbit(count);
+    size_t nw = (nbits + 63) >> 6;
+    size_t total_words = (total + 63) >> 6;
+    if(off == 0){
+        memcpy(bs->data + w, src, nw * sizeof(uint64_t));
+    }else{
+        bs->data[w] &= ((uint64_t)1 << off) - 1; // drop stale bits past count
+        for(size_t i = 0; i < nw; i++){
+            bs->data[w + i] |= src[i] << off;
+            if(w + i + 1 < total_words)
+                bs->data[w + i + 1] = src[i] >> (64 - off);
+        }
+    }
+    if(_valbit(total))
+        bs->data[total_words - 1] &= ((uint64_t)1 << _valbit(total)) - 1;
+    bs->count = total;
+}
+
+void bitset_from_words(bitset_t* bs, const uint64_t* words, size_t nbits){
+    if(bs == NULL) return;
+    bitset_init(bs);
+    bitset_append_bits(bs, words, nbits);
+}
+
+void bitset_push(bitset_t* bs, int val){
+    if(bs == NULL) return;
+    bitset_maybe_expand(bs);
+
+    size_t intindex = _intindex(bs->count);
+    size_t valbit = _valbit(bs->count);
+    bs->data[intindex] = (bs->data[intindex] & ~((uint64_t)1 << valbit)) | ((uint64_t)!!val << valbit);
+    bs->count++;
+}
+
+int bitset_get(bitset_t* bs, size_t index){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    size_t intindex = _intindex(index);
+    size_t valbit = _valbit(index);
+    return (bs->data[intindex] >> valbit) & 1;
+}
+int bitset_peek(bitset_t* bs){
+    if(bs == NULL || bs->count == 0) return 0;
+
+    return bitset_get(bs, bs->count - 1);
+}
+
+int bitset_clean(bitset_t* bs, size_t index){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    size_t intindex = _intindex(index);
+    size_t valbit = _valbit(index);
+
+    bs->data[intindex] &= ~((uint64_t)1 << valbit);
+    return (bs->data[intindex] >> valbit) & 1;
+}
+int bitset_put(bitset_t* bs, size_t index){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    size_t intindex = _intindex(index);
+    size_t valbit = _valbit(index);
+
+    bs->data[intindex] |= (uint64_t)1 << valbit;
+    return (bs->data[intindex] >> valbit) & 1;
+}
+int bitset_set(bitset_t* bs, size_t index, int val){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    size_t intindex = _intindex(index);
+    size_t valbit = _valbit(index);
+
+    bs->data[intindex] = (bs->data[intindex] & ~((uint64_t)1 << valbit)) | ((uint64_t)!!val << valbit);
+    return (bs->data[intindex] >> valbit) & 1;
+}
+int bitset_toggle(bitset_t* bs, size_t index){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    size_t intindex = _intindex(index);
+    size_t valbit = _valbit(index);
+
+    bs->data[intindex] ^= (uint64_t)1 << valbit;
+    return (bs->data[intindex] >> valbit) & 1;
+}
+
+int bitset_erase(bitset_t* bs, size_t index){
+    if(bs == NULL || bs->count == 0) return 0;
+    assert(index < bs->count);
+
+    int val = bitset_get(bs, index);
+    bitset_erase_range(bs, index, 1);
+    return val;
+}
+int bitset_pop(bitset_t* bs){
+    if(bs == NULL || bs->count == 0) return 0;
+
+    return bitset_erase(bs, bs->count - 1);
+}
+
+void bitset_insert(bitset_t* bs, size_t index, int val){
+    bitset_insert_bits(bs, index, 1, val);
+}
+
+
+typedef void (*_bitset_binop_t)(uint64_t*, const uint64_t*, const uint64_t*, size_t);
+typedef size_t (*_bitset_countop_t)(const uint64_t*, size_t);
+typedef void (*_bitset_shiftop_t)(uint64_t*, const uint64_t*, size_t, unsigned);
+
+// x is word/vector of a, y of b
+#define _BITSET_SCALAR_BINOP(name, expr) \
+static void _bitset_##name##_scalar(uint64_t* d, const uint64_t* a, const uint64_t* b, size_t n){ \
+    for(size_t i = 0; i < n; i++){ \
+        uint64_t x = a[i], y = b[i]; (void)y; \
+        d[i] = (expr); \
+    } \
+}
+_BITSET_SCALAR_BINOP(and, x & y)
+_BITSET_SCALAR_BINOP(or, x | y)
+_BITSET_SCALAR_BINOP(xor, x ^ y)
+_BITSET_SCALAR_BINOP(andnot, x & ~y)
+_BITSET_SCALAR_BINOP(not, ~x)
+
+static size_t _bitset_count_scalar(const uint64_t* a, size_t n){
+    size_t c = 0;
+    for(size_t i = 0; i < n; i++)
+        c += __builtin_popcountll(a[i]);
+    return c;
+}
+
+// funnel shifts by 0 < r < 64 over a word stream, safe in place
+// shr goes up from d[0] and reads s[n], needs d <= s. shl goes down from d[n - 1] and reads s[-1], needs d >= s
+static void _bitset_shr_scalar(uint64_t* d, const uint64_t* s, size_t n, unsigned r){
+    for(size_t i = 0; i < n; i++)
+        d[i] = (s[i] >> r) | (s[i + 1] << (64 - r));
+}
+static void _bitset_shl_scalar(uint64_t* d, const uint64_t* s, size_t n, unsigned r){
+    for(size_t i = n; i-- > 0;)
+        d[i] = (s[i] << r) | (s[i - 1] >> (64 - r));
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _BITSET_X86
+#include <immintrin.h>
+
+#define _BITSET_AVX2_BINOP(name, vexpr, expr) \
+__attribute__((target("avx2"))) \
+static void _bitset_##name##_avx2(uint64_t* d, const uint64_t* a, const uint64_t* b, size_t n){ \
+    size_t i = 0; \
+    for(; i + 4 <= n; i += 4){ \
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i)); \
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i)); (void)y; \
+        _mm256_storeu_si256((__m256i*)(d + i), (vexpr)); \
+    } \
+    for(; i < n; i++){ \
+        uint64_t x = a[i], y = b[i]; (void)y; \
+        d[i] = (expr); \
+    } \
+}
+_BITSET_AVX2_BINOP(and, _mm256_and_si256(x, y), x & y)
+_BITSET_AVX2_BINOP(or, _mm256_or_si256(x, y), x | y)
+_BITSET_AVX2_BINOP(xor, _mm256_xor_si256(x, y), x ^ y)
+_BITSET_AVX2_BINOP(andnot, _mm256_andnot_si256(y, x), x & ~y)
+_BITSET_AVX2_BINOP(not, _mm256_xor_si256(x, _mm256_set1_epi64x(-1)), ~x)
+
+#define _BITSET_AVX512_BINOP(name, vexpr, expr) \
+__attribute__((target("avx512f"))) \
+static void _bitset_##name##_avx512(uint64_t* d, const uint64_t* a, const uint64_t* b, size_t n){ \
+    size_t i = 0; \
+    for(; i + 8 <= n; i += 8){ \
+        __m512i x = _mm512_loadu_si512((const void*)(a + i)); \
+        __m512i y = _mm512_loadu_si512((const void*)(b + i)); (void)y; \
+        _mm512_storeu_si512((void*)(d + i), (vexpr)); \
+    } \
+    for(; i < n; i++){ \
+        uint64_t x = a[i], y = b[i]; (void)y; \
+        d[i] = (expr); \
+    } \
+}
+_BITSET_AVX512_BINOP(and, _mm512_and_si512(x, y), x & y)
+_BITSET_AVX512_BINOP(or, _mm512_or_si512(x, y), x | y)
+_BITSET_AVX512_BINOP(xor, _mm512_xor_si512(x, y), x ^ y)
+_BITSET_AVX512_BINOP(andnot, _mm512_andnot_si512(y, x), x & ~y)
+_BITSET_AVX512_BINOP(not, _mm512_ternarylogic_epi64(x, x, x, 0x55), ~x)
+
+// both loads of a step happen before its store, and the store only covers words already read, so in place is fine
+__attribute__((target("avx2")))
+static void _bitset_shr_avx2(uint64_t* d, const uint64_t* s, size_t n, unsigned r){
+    __m128i cr = _mm_cvtsi32_si128((int)r);
+    __m128i cl = _mm_cvtsi32_si128((int)(64 - r));
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(s + i + 1));
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_or_si256(_mm256_srl_epi64(lo, cr), _mm256_sll_epi64(hi, cl)));
+    }
+    for(; i < n; i++)
+        d[i] = (s[i] >> r) | (s[i + 1] << (64 - r));
+}
+__attribute__((target("avx2")))
+static void _bitset_shl_avx2(uint64_t* d, const uint64_t* s, size_t n, unsigned r){
+    __m128i cl = _mm_cvtsi32_si128((int)r);
+    __m128i cr = _mm_cvtsi32_si128((int)(64 - r));
+    size_t i = n;
+    for(; i >= 4; i -= 4){
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(s + i - 4));
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(s + i - 5));
+        _mm256_storeu_si256((__m256i*)(d + i - 4), _mm256_or_si256(_mm256_sll_epi64(hi, cl), _mm256_srl_epi64(lo, cr)));
+    }
+    while(i-- > 0)
+        d[i] = (s[i] << r) | (s[i - 1] >> (64 - r));
+}
+
+__attribute__((target("popcnt")))
+static size_t _bitset_count_popcnt(const uint64_t* a, size_t n){
+    size_t c = 0;
+    for(size_t i = 0; i < n; i++)
+        c += __builtin_popcountll(a[i]);
+    return c;
+}
+
+// nibble lookup popcount (Mula), bytes summed with sad
+__attribute__((target("avx2")))
+static size_t _bitset_count_avx2(const uint64_t* a, size_t n){
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+    size_t c = (size_t)_mm256_extract_epi64(acc, 0) + (size_t)_mm256_extract_epi64(acc, 1) +
+               (size_t)_mm256_extract_epi64(acc, 2) + (size_t)_mm256_extract_epi64(acc, 3);
+    for(; i < n; i++)
+        c += __builtin_popcountll(a[i]);
+    return c;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t _bitset_count_avx512(const uint64_t* a, size_t n){
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512((const void*)(a + i))));
+    }
+    size_t c = (size_t)_mm512_reduce_add_epi64(acc);
+    for(; i < n; i++)
+        c += __builtin_popcountll(a[i]);
+    return c;
+}
+#endif
+
+// run once guard that needs no pthread, state 0 = not run, 1 = running, 2 = done.
+// returns 1 to the single caller that should run the init and then call _bitset_once_end, others wait until it is done
+static int _bitset_once_begin(int* state){
+    if(__atomic_load_n(state, __ATOMIC_ACQUIRE) == 2) return 0;
+    int expected = 0;
+    if(__atomic_compare_exchange_n(state, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return 1;
+    while(__atomic_load_n(state, __ATOMIC_ACQUIRE) != 2); // init is short, spin
+    return 0;
+}
+static void _bitset_once_end(int* state){
+    __atomic_store_n(state, 2, __ATOMIC_RELEASE);
+}
+
+static struct {
+    int ready; // _bitset_once state
+    _bitset_binop_t and_, or_, xor_, andnot_, not_;
+    _bitset_countop_t count;
+    _bitset_shiftop_t shr_, shl_;
+} _bitset_kernels;
+
+// picks widest kernels the cpu supports, once, safe to race on
+static void _bitset_dispatch(void){
+    if(!_bitset_once_begin(&_bitset_kernels.ready)) return;
+    _bitset_kernels.and_ = _bitset_and_scalar;
+    _bitset_kernels.or_ = _bitset_or_scalar;
+    _bitset_kernels.xor_ = _bitset_xor_scalar;
+    _bitset_kernels.andnot_ = _bitset_andnot_scalar;
+    _bitset_kernels.not_ = _bitset_not_scalar;
+    _bitset_kernels.count = _bitset_count_scalar;
+    _bitset_kernels.shr_ = _bitset_shr_scalar;
+    _bitset_kernels.shl_ = _bitset_shl_scalar;
+#ifdef _BITSET_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("popcnt")){
+        _bitset_kernels.count = _bitset_count_popcnt;
+    }
+    if(__builtin_cpu_supports("avx2")){
+        _bitset_kernels.and_ = _bitset_and_avx2;
+        _bitset_kernels.or_ = _bitset_or_avx2;
+        _bitset_kernels.xor_ = _bitset_xor_avx2;
+        _bitset_kernels.andnot_ = _bitset_andnot_avx2;
+        _bitset_kernels.not_ = _bitset_not_avx2;
+        _bitset_kernels.count = _bitset_count_avx2;
+        _bitset_kernels.shr_ = _bitset_shr_avx2;
+        _bitset_kernels.shl_ = _bitset_shl_avx2;
+    }
+    if(__builtin_cpu_supports("avx512f")){
+        _bitset_kernels.and_ = _bitset_and_avx512;
+        _bitset_kernels.or_ = _bitset_or_avx512;
+        _bitset_kernels.xor_ = _bitset_xor_avx512;
+        _bitset_kernels.andnot_ = _bitset_andnot_avx512;
+        _bitset_kernels.not_ = _bitset_not_avx512;
+    }
+    if(__builtin_cpu_supports("avx512vpopcntdq")){
+        _bitset_kernels.count = _bitset_count_avx512;
+    }
+#endif
+    _bitset_once_end(&_bitset_kernels.ready);
+}
+
+// makes dst hold count bits, keeps data if it already fits (dst can alias a source)
+static void _bitset_fit(bitset_t* dst, size_t count){
+    size_t words = _bitset_words(count);
+    if(dst->cap < words){
+        dst->data = (uint64_t*)realloc(dst->data, words * sizeof(uint64_t));
+        dst->cap = words;
+    }
+    dst->count = count;
+}
+
+static void _bitset_binop(bitset_t* dst, const bitset_t* a, const bitset_t* b, _bitset_binop_t* op){
+    if(dst == NULL || a == NULL || b == NULL) return;
+    assert(a->count == b->count);
+    size_t count = a->count;
+    _bitset_fit(dst, count);
+    if(count == 0) return;
+    _bitset_dispatch();
+    size_t words = _bitset_words(count);
+    (*op)(dst->data, a->data, b->data, words);
+    dst->data[words - 1] &= _bitset_tail_mask(count);
+}
+
+void bitset_and(bitset_t* dst, const bitset_t* a, const bitset_t* b){
+    _bitset_binop(dst, a, b, &_bitset_kernels.and_);
+}
+void bitset_or(bitset_t* dst, const bitset_t* a, const bitset_t* b){
+    _bitset_binop(dst, a, b, &_bitset_kernels.or_);
+}
+void bitset_xor(bitset_t* dst, const bitset_t* a, const bitset_t* b){
+    _bitset_binop(dst, a, b, &_bitset_kernels.xor_);
+}
+void bitset_andnot(bitset_t* dst, const bitset_t* a, const bitset_t* b){
+    _bitset_binop(dst, a, b, &_bitset_kernels.andnot_);
+}
+void bitset_not(bitset_t* dst, const bitset_t* a){
+    _bitset_binop(dst, a, a, &_bitset_kernels.not_);
+}
+
+size_t bitset_count(const bitset_t* bs){
+    if(bs == NULL || bs->count == 0) return 0;
+    _bitset_dispatch();
+    size_t words = _bitset_words(bs->count);
+    return _bitset_kernels.count(bs->data, words - 1) +
+           __builtin_popcountll(bs->data[words - 1] & _bitset_tail_mask(bs->count));
+}
+
+int bitset_any(const bitset_t* bs){
+    if(bs == NULL || bs->count == 0) return 0;
+    size_t words = _bitset_words(bs->count);
+    for(size_t i = 0; i < words - 1; i++){
+        if(bs->data[i]) return 1;
+    }
+    return (bs->data[words - 1] & _bitset_tail_mask(bs->count)) != 0;
+}
+int bitset_none(const bitset_t* bs){
+    return !bitset_any(bs);
+}
+int bitset_all(const bitset_t* bs){
+    if(bs == NULL) return 0;
+    if(bs->count == 0) return 1;
+    size_t words = _bitset_words(bs->count);
+    for(size_t i = 0; i < words - 1; i++){
+        if(bs->data[i] != ~(uint64_t)0) return 0;
+    }
+    uint64_t mask = _bitset_tail_mask(bs->count);
+    return (bs->data[words - 1] & mask) == mask;
+}
+
+// word j of the result is the old stream from word w shifted by nbits, so only the words from index on are touched
+void bitset_insert_bits(bitset_t* bs, size_t index, size_t nbits, int val){
+    if(bs == NULL || nbits == 0) return;
+    assert(index <= bs->count);
+    size_t total = bs->count + nbits;
+    bitset_maybe_expand_to(bs, total);
+
+    size_t words = _bitset_words(bs->count);
+    size_t new_words = _bitset_words(total);
+    size_t w = _intindex(index);
+    if(w < words){
+        uint64_t* d = bs->data;
+        size_t q = _intindex(nbits);
+        unsigned r = _valbit(nbits);
+        uint64_t low = ((uint64_t)1 << _valbit(index)) - 1;
+        uint64_t keep = d[w] & low;
+        if(r == 0){
+            memmove(d + w + q, d + w, (new_words - w - q) * sizeof(uint64_t));
+        }else{
+            _bitset_dispatch();
+            _bitset_kernels.shl_(d + w + q + 1, d + w + 1, new_words - w - q - 1, r);
+            d[w + q] = d[w] << r;
+        }
+        d[w] = (d[w] & ~low) | keep;
+    }
+    _bitset_fill(bs, index, nbits, val);
+    bs->count = total;
+}
+
+void bitset_erase_range(bitset_t* bs, size_t index, size_t nbits){
+    if(bs == NULL || nbits == 0) return;
+    assert(index + nbits <= bs->count);
+
+    uint64_t* d = bs->data;
+    size_t words = _bitset_words(bs->count);
+    size_t w = _intindex(index);
+    size_t q = _intindex(nbits);
+    unsigned r = _valbit(nbits);
+    size_t n = words - w - q; // result words that still get old bits
+    uint64_t low = ((uint64_t)1 << _valbit(index)) - 1;
+    uint64_t keep = d[w] & low;
+    if(r == 0){
+        memmove(d + w, d + w + q, n * sizeof(uint64_t));
+    }else if(n > 0){
+        _bitset_dispatch();
+        _bitset_kernels.shr_(d + w, d + w + q, n - 1, r);
+        d[words - q - 1] = d[words - 1] >> r;
+    }
+    memset(d + words - q, 0, q * sizeof(uint64_t));
+    d[w] = (d[w] & ~low) | keep;
+    bs->count -= nbits;
+}
+
+
+size_t bitset_find_next(const bitset_t* bs, size_t from){
+    if(bs == NULL) return 0;
+    if(from >= bs->count) return bs->count;
+    size_t words = _bitset_words(bs->count);
+    size_t w = _intindex(from);
+    uint64_t bits = bs->data[w] & (~(uint64_t)0 << _valbit(from)); // drop bits before from
+    while(bits == 0){
+        if(++w >= words) return bs->count;
+        bits = bs->data[w];
+    }
+    size_t index = (w << 6) + __builtin_ctzll(bits);
+    return index < bs->count ? index : bs->count; // stale bits past count
+}
+size_t bitset_find_first(const bitset_t* bs){
+    return bitset_find_next(bs, 0);
+}
+
+size_t bitset_find_next_zero(const bitset_t* bs, size_t from){
+    if(bs == NULL) return 0;
+    if(from >= bs->count) return bs->count;
+    size_t words = _bitset_words(bs->count);
+    size_t w = _intindex(from);
+    uint64_t bits = ~bs->data[w] & (~(uint64_t)0 << _valbit(from));
+    while(bits == 0){
+        if(++w >= words) return bs->count;
+        bits = ~bs->data[w];
+    }
+    size_t index = (w << 6) + __builtin_ctzll(bits);
+    return index < bs->count ? index : bs->count;
+}
+size_t bitset_find_first_zero(const bitset_t* bs){
+    return bitset_find_next_zero(bs, 0);
+}
+
+
+#define _BITSET_BLOCK_SHIFT 9
+#define _BITSET_SUPER_SHIFT 16
+#define _BITSET_SAMPLE_SHIFT 12
+#define _BITSET_BLOCK_WORDS (1 << (_BITSET_BLOCK_SHIFT - 6))
+
+static uint8_t _bitset_select_in_byte[256][8]; // [byte][r] = index of r-th set bit in byte
+
+static void _bitset_select_table_init(void){
+    static int ready = 0; // _bitset_once state
+    if(!_bitset_once_begin(&ready)) return;
+    for(int b = 0; b < 256; b++){
+        int r = 0;
+        for(int i = 0; i < 8; i++){
+            if((b >> i) & 1)
+                _bitset_select_in_byte[b][r++] = (uint8_t)i;
+        }
+    }
+    _bitset_once_end(&ready);
+}
+
+static inline unsigned _bitset_select_in_word(uint64_t w, unsigned r){
+    unsigned shift = 0;
+    while(1){
+        unsigned byte = (w >> shift) & 0xff;
+        unsigned c = __builtin_popcount(byte);
+        if(r < c) return shift + _bitset_select_in_byte[byte][r];
+        r -= c;
+        shift += 8;
+    }
+}
+
+static inline uint64_t _bitset_word_masked(const bitset_t* bs, size_t w){
+    return w + 1 == _bitset_words(bs->count) ? bs->data[w] & _bitset_tail_mask(bs->count) : bs->data[w];
+}
+
+static inline size_t _bitset_block_rank(const bitset_rank_index_t* ri, size_t b){
+    return ri->supers[b >> (_BITSET_SUPER_SHIFT - _BITSET_BLOCK_SHIFT)] + ri->blocks[b];
+}
+
+void bitset_rank_index_build(bitset_rank_index_t* ri, const bitset_t* bs){
+    _bitset_select_table_init();
+    _bitset_dispatch();
+    ri->bs = bs;
+    size_t count = bs ? bs->count : 0;
+    size_t words = _bitset_words(count);
+    ri->nblocks = (count >> _BITSET_BLOCK_SHIFT) + 1; // +1 so rank(count) has a block to start from
+    ri->supers = (uint64_t*)malloc(((count >> _BITSET_SUPER_SHIFT) + 1) * sizeof(uint64_t));
+    ri->blocks = (uint16_t*)malloc(ri->nblocks * sizeof(uint16_t));
+
+    size_t total = 0;
+    size_t super_start = 0;
+    for(size_t b = 0; b < ri->nblocks; b++){
+        if((b & ((1 << (_BITSET_SUPER_SHIFT - _BITSET_BLOCK_SHIFT)) - 1)) == 0){
+            ri->supers[b >> (_BITSET_SUPER_SHIFT - _BITSET_BLOCK_SHIFT)] = total;
+            super_start = total;
+        }
+        ri->blocks[b] = (uint16_t)(total - super_start);
+        size_t w = b * _BITSET_BLOCK_WORDS;
+        size_t wend = w + _BITSET_BLOCK_WORDS < words ? w + _BITSET_BLOCK_WORDS : words;
+        for(; w < wend; w++)
+            total += __builtin_popcountll(_bitset_word_masked(bs, w));
+    }
+    ri->ones = total;
+
+    size_t nsamples = (total >> _BITSET_SAMPLE_SHIFT) + 1;
+    ri->samples = (uint32_t*)malloc(nsamples * sizeof(uint32_t));
+    size_t s = 0;
+    for(size_t b = 0; b < ri->nblocks && s < nsamples; b++){
+        size_t end = b + 1 < ri->nblocks ? _bitset_block_rank(ri, b + 1) : total;
+        while(s < nsamples && (s << _BITSET_SAMPLE_SHIFT) < end){
+            ri->samples[s++] = (uint32_t)b;
+        }
+    }
+    for(; s < nsamples; s++) // only when there are no set bits at all
+        ri->samples[s] = 0;
+}
+
+void bitset_rank_index_destroy(bitset_rank_index_t* ri){
+    if(ri == NULL) return;
+    free(ri->supers);
+    free(ri->blocks);
+    free(ri->samples);
+    ri->supers = NULL;
+    ri->blocks = NULL;
+    ri->samples = NULL;
+    ri->ones = 0;
+    ri->nblocks = 0;
+}
+
+size_t bitset_rank(const bitset_rank_index_t* ri, size_t i){
+    if(ri == NULL || ri->bs == NULL) return 0;
+    assert(i <= ri->bs->count);
+    const uint64_t* data = ri->bs->data;
+    size_t b = i >> _BITSET_BLOCK_SHIFT;
+    size_t r = _bitset_block_rank(ri, b);
+    size_t w = b * _BITSET_BLOCK_WORDS;
+    size_t wend = _intindex(i);
+    for(; w < wend; w++)
+        r += __builtin_popcountll(data[w]);
+    if(_valbit(i))
+        r += __builtin_popcountll(data[wend] & (((uint64_t)1 << _valbit(i)) - 1));
+    return r;
+}
+
+size_t bitset_select(const bitset_rank_index_t* ri, size_t k){
+    if(ri == NULL || ri->bs == NULL) return 0;
+    if(k >= ri->ones) return ri->bs->count;
+    size_t s = k >> _BITSET_SAMPLE_SHIFT;
+    size_t lo = ri->samples[s];
+    size_t hi = (s + 1 < (ri->ones >> _BITSET_SAMPLE_SHIFT) + 1) ? ri->samples[s + 1] : ri->nblocks - 1;
+    while(lo < hi){ // last block with rank <= k
+        size_t mid = (lo + hi + 1) >> 1;
+        if(_bitset_block_rank(ri, mid) <= k)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    size_t r = k - _bitset_block_rank(ri, lo);
+    const uint64_t* data = ri->bs->data;
+    size_t w = lo * _BITSET_BLOCK_WORDS;
+    while(1){
+        size_t c = __builtin_popcountll(data[w]);
+        if(r < c) return (w << 6) + _bitset_select_in_word(data[w], (unsigned)r);
+        r -= c;
+        w++;
+    }
+}
+
+#endif
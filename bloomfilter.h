@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "bitset.h"
+
+// blocked bloom filter: every key sets/tests k bits inside one 64 byte (512 bit) block,
+// so a lookup costs one cache miss no matter k. bits live in bitset_t words, blocks are cache line aligned
+// keys come in as one 64 bit hash, the block is picked from it and the k bit positions are derived by double hashing
+// only uses the public bitset api, BITSET_IMPLEMENTATION has to be defined in one file too (e.g. next to BLOOMFILTER_IMPLEMENTATION)
+
+typedef struct bloom_t {
+    bitset_t bits;
+    size_t nblocks;
+    uint32_t k;
+} bloom_t;
+
+void bloom_init(bloom_t* bf, size_t nblocks, uint32_t k);
+// picks block count and k for expected keys at false positive rate fpr
+void bloom_init_for(bloom_t* bf, size_t expected, double fpr);
+void bloom_clear(bloom_t* bf);
+void bloom_destroy(bloom_t* bf);
+
+void bloom_add_hash(bloom_t* bf, uint64_t hash);
+// 0 = definitely not added, 1 = maybe added
+int bloom_maybe_contains_hash(const bloom_t* bf, uint64_t hash);
+
+// for integer/pointer keys, same mixer hashset uses by default
+#define bloom_add(bf, key)             bloom_add_hash(bf, bloom_mix((uint64_t)(key)))
+#define bloom_maybe_contains(bf, key)  bloom_maybe_contains_hash(bf, bloom_mix((uint64_t)(key)))
+
+// dst |= src, both must have same nblocks and k. ok = 1, mismatch = 0
+int bloom_union(bloom_t* dst, const bloom_t* src);
+
+size_t bloom_serialized_size(const bloom_t* bf);
+// out must hold bloom_serialized_size bytes, returns bytes written
+size_t bloom_serialize(const bloom_t* bf, uint8_t* out);
+// ok = 1, malformed = 0
+int bloom_deserialize(bloom_t* bf, const uint8_t* buf, size_t len);
+
+// same as _murmur3 in hashset.h, so a key hashed for the set can go straight into bloom_add_hash
+static inline uint64_t bloom_mix(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+
+#ifdef BLOOMFILTER_IMPLEMENTATION
+
+#include <string.h>
+#include <math.h>
+
+#define _BLOOM_BLOCK_WORDS 8
+#define _BLOOM_MAX_K 16
+#define _BLOOM_MAGIC 0x314d4c42 // "BLM1"
+
+void bloom_init(bloom_t* bf, size_t nblocks, uint32_t k){
+    if(nblocks < 1)
+        nblocks = 1;
+    if(k < 1)
+        k = 1;
+    if(k > _BLOOM_MAX_K)
+        k = _BLOOM_MAX_K;
+    bf->nblocks = nblocks;
+    bf->k = k;
+    size_t words = nblocks * _BLOOM_BLOCK_WORDS;
+    bf->bits.data = (uint64_t*)aligned_alloc(64, words * sizeof(uint64_t));
+    memset(bf->bits.data, 0, words * sizeof(uint64_t));
+    bf->bits.count = words << 6;
+    bf->bits.cap = words;
+}
+
+// fpr of a blocked filter: keys per block are poisson distributed, each block behaves like a small standard filter
+static double _bloom_blocked_fpr(double keys_per_block, uint32_t k){
+    double p = exp(-keys_per_block);
+    double fpr = 0;
+    size_t end = (size_t)(keys_per_block + 10 * sqrt(keys_per_block) + 20);
+    for(size_t i = 0; i <= end; i++){
+        fpr += p * pow(1 - pow(1 - 1.0 / 512, (double)k * i), k);
+        p *= keys_per_block / (i + 1);
+    }
+    return fpr;
+}
+
+void bloom_init_for(bloom_t* bf, size_t expected, double fpr){
+    if(expected < 1)
+        expected = 1;
+    if(fpr <= 0 || fpr >= 1)
+        fpr = 0.01;
+    // grow bits per key until some k reaches fpr, blocking needs a bit more than the textbook 1.44 * log2(1 / fpr)
+    for(double bits_per_key = 1; bits_per_key < 64; bits_per_key += 0.25){
+        double keys_per_block = 512 / bits_per_key;
+        for(uint32_t k = 1; k <= _BLOOM_MAX_K; k++){
+            if(_bloom_blocked_fpr(keys_per_block, k) <= fpr){
+                bloom_init(bf, (size_t)ceil(expected / keys_per_block), k);
+                return;
+            }
+        }
+    }
+    bloom_init(bf, (size_t)ceil(expected / 8.0), _BLOOM_MAX_K);
+}
+
+void bloom_clear(bloom_t* bf){
+    if(bf == NULL || bf->bits.data == NULL) return;
+    memset(bf->bits.data, 0, bf->bits.cap * sizeof(uint64_t));
+}
+
+void bloom_destroy(bloom_t* bf){
+    if(bf == NULL) return;
+    bitset_destroy(&bf->bits);
+    bf->nblocks = 0;
+}
+
+// high 64 bits of a * b
+static inline uint64_t _bloom_mulhi(uint64_t a, uint64_t b){
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t lh = la * hb, hl = ha * lb;
+    uint64_t mid = ((la * lb) >> 32) + (uint32_t)lh + (uint32_t)hl;
+    return ha * hb + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+static inline uint64_t* _bloom_block(const bloom_t* bf, uint64_t hash){
+    size_t block = (size_t)_bloom_mulhi(hash, bf->nblocks); // high bits of hash pick the block
+    return bf->bits.data + block * _BLOOM_BLOCK_WORDS;
+}
+
+// k 9 bit positions inside the block, from the hash remixed so they dont correlate with the block choice
+static inline void _bloom_masks(const bloom_t* bf, uint64_t hash, uint64_t mask[_BLOOM_BLOCK_WORDS]){
+    hash *= 0x9e3779b97f4a7c15;
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    memset(mask, 0, _BLOOM_BLOCK_WORDS * sizeof(uint64_t));
+    for(uint32_t i = 0; i < bf->k; i++){
+        uint32_t pos = (h1 + i * h2) >> 23;
+        mask[pos >> 6] |= (uint64_t)1 << (pos & 63);
+    }
+}
+
+void bloom_add_hash(bloom_t* bf, uint64_t hash){
+    if(bf == NULL || bf->bits.data == NULL) return;
+    uint64_t mask[_BLOOM_BLOCK_WORDS];
+    _bloom_masks(bf, hash, mask);
+    uint64_t* block = _bloom_block(bf, hash);
+    for(int i = 0; i < _BLOOM_BLOCK_WORDS; i++)
+        block[i] |= mask[i];
+}
+
+int bloom_maybe_contains_hash(const bloom_t* bf, uint64_t hash){
+    if(bf == NULL || bf->bits.data == NULL) return 0;
+    uint64_t mask[_BLOOM_BLOCK_WORDS];
+    _bloom_masks(bf, hash, mask);
+    const uint64_t* block = _bloom_block(bf, hash);
+    uint64_t missing = 0;
+    for(int i = 0; i < _BLOOM_BLOCK_WORDS; i++) // no early exit, whole block is one line anyway
+        missing |= mask[i] & ~block[i];
+    return missing == 0;
+}
+
+int bloom_union(bloom_t* dst, const bloom_t* src){
+    if(dst == NULL || src == NULL) return 0;
+    if(dst->nblocks != src->nblocks || dst->k != src->k) return 0;
+    bitset_or(&dst->bits, &dst->bits, &src->bits);
+    return 1;
+}
+
+static void _bloom_put64(uint8_t* p, uint64_t v){
+    for(int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+static uint64_t _bloom_get64(const uint8_t* p){
+    uint64_t v = 0;
+    for(int i = 0; i < 8; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+// little endian: u32 magic, u32 k, u64 nblocks, then the words
+size_t bloom_serialized_size(const bloom_t* bf){
+    if(bf == NULL) return 0;
+    return 16 + bf->bits.cap * sizeof(uint64_t);
+}
+
+size_t bloom_serialize(const bloom_t* bf, uint8_t* out){
+    if(bf == NULL || out == NULL) return 0;
+    _bloom_put64(out, _BLOOM_MAGIC | ((uint64_t)bf->k << 32));
+    _bloom_put64(out + 8, bf->nblocks);
+    uint8_t* p = out + 16;
+    for(size_t i = 0; i < bf->bits.cap; i++, p += 8)
+        _bloom_put64(p, bf->bits.data[i]);
+    return (size_t)(p - out);
+}
+
+int bloom_deserialize(bloom_t* bf, const uint8_t* buf, size_t len){
+    if(bf == NULL || buf == NULL || len < 16) return 0;
+    uint64_t head = _bloom_get64(buf);
+    uint64_t nblocks = _bloom_get64(buf + 8);
+    uint32_t k = (uint32_t)(head >> 32);
+    if((uint32_t)head != _BLOOM_MAGIC || k < 1 || k > _BLOOM_MAX_K || nblocks < 1) return 0;
+    if(nblocks > (len - 16) / (_BLOOM_BLOCK_WORDS * sizeof(uint64_t)) || len - 16 != nblocks * _BLOOM_BLOCK_WORDS * sizeof(uint64_t)) return 0;
+    bloom_init(bf, (size_t)nblocks, k);
+    const uint8_t* p = buf + 16;
+    for(size_t i = 0; i < bf->bits.cap; i++, p += 8)
+        bf->bits.data[i] = _bloom_get64(p);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "hashmap.h"
+
+// hashmap_t split into shards by high hash bits, every shard has its own writer mutex and seqlock
+// readers take no lock: they snapshot the shard table, probe it with the hashmap_t probing and retry if a writer ran meanwhile,
+// user equal only runs while the shard is unchanged so slots can be reused under a reader
+// writers grow into fresh arrays and free the old ones once no reader can still see them (epoch based: a reader publishes the
+// epoch it started in, arrays replaced in an older epoch than every running reader's are freed by the next write to that shard)
+// keys are not copied, key memory must stay valid as long as readers may still compare against it
+// needs swiss layout, so not usable with HASHMAP_ROBINHOOD or HASHMAP_INCREMENTAL
+
+typedef struct chm_retired_t {
+    void* ptr;
+    uint64_t epoch; // epoch it was replaced in
+} chm_retired_t;
+
+typedef struct chm_shard_t {
+    _Alignas(64) _Atomic uint64_t seq; // odd while a writer changes table
+    pthread_mutex_t lock;
+    hashmap_t hm;
+    chm_retired_t* retired; // replaced items/ctrl arrays readers may still hold
+    size_t nretired;
+    size_t retired_cap;
+} chm_shard_t;
+
+typedef struct chashmap_t {
+    chm_shard_t* shards;
+    size_t nshards; // power of 2
+    unsigned shift; // hash >> shift = shard
+
+    size_t (*_hash) (const void*, size_t);
+    int (*_equal) (const void*, const void*, size_t);
+} chashmap_t;
+
+#define CHASHMAP_DEFAULT_SHARDS 64
+
+// nshards gets rounded up to power of 2, 0 = CHASHMAP_DEFAULT_SHARDS. hash/equal as for hashmap_init
+void chashmap_init(chashmap_t* chm, size_t nshards, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t));
+void chashmap_destroy(chashmap_t* chm);
+
+// same return values as hashmap ones
+int chashmap_set_n_(chashmap_t* chm, const void* key, size_t len, void* value);
+int chashmap_tryadd_n_(chashmap_t* chm, const void* key, size_t len, void* value);
+int chashmap_trychange_n_(chashmap_t* chm, const void* key, size_t len, void* value);
+// lock free
+void* chashmap_get_n(chashmap_t* chm, const void* key, size_t len);
+void* chashmap_remove_n(chashmap_t* chm, const void* key, size_t len);
+
+int chashmap_set_(chashmap_t* chm, const char* key, void* value);
+int chashmap_tryadd_(chashmap_t* chm, const char* key, void* value);
+int chashmap_trychange_(chashmap_t* chm, const char* key, void* value);
+void* chashmap_get(chashmap_t* chm, const char* key);
+void* chashmap_remove(chashmap_t* chm, const char* key);
+
+// sum of shard counts, exact only when no writer runs
+size_t chashmap_count(chashmap_t* chm);
+// calls fn for every entry, one shard at a time with its writer lock held, so each shard is seen in one consistent state
+void chashmap_foreach(chashmap_t* chm, void (*fn) (const char* key, size_t len, void* value, void* ctx), void* ctx);
+// frees arrays left over from growing that no running reader can still see, writers already do this on their own
+void chashmap_reclaim(chashmap_t* chm);
+
+#define chashmap_set(chm, key, value)       chashmap_set_(chm, key, (void*)value)
+#define chashmap_tryadd(chm, key, value)    chashmap_tryadd_(chm, key, (void*)value)
+#define chashmap_trychange(chm, key, value) chashmap_trychange_(chm, key, (void*)value)
+#define chashmap_set_n(chm, key, len, value)       chashmap_set_n_(chm, key, len, (void*)value)
+#define chashmap_tryadd_n(chm, key, len, value)    chashmap_tryadd_n_(chm, key, len, (void*)value)
+#define chashmap_trychange_n(chm, key, len, value) chashmap_trychange_n_(chm, key, len, (void*)value)
+
+
+#ifdef CHASHMAP_IMPLEMENTATION
+
+#ifndef HASHMAP_IMPLEMENTATION
+#error "chashmap needs hashmap internals, define HASHMAP_IMPLEMENTATION before including hashmap.h/chashmap.h in this file"
+#endif
+#if defined(HASHMAP_ROBINHOOD) || defined(HASHMAP_INCREMENTAL)
+#error "chashmap needs the default hashmap layout"
+#endif
+
+#include <string.h>
+
+// reader state for _chm_equal, which has no context argument
+static _Thread_local struct {
+    _Atomic uint64_t* seq;
+    uint64_t start;
+    int (*equal) (const void*, const void*, size_t);
+} _chm_reader;
+
+// a racing writer can leave the probed item half visible, so user equal only runs while the shard is still unchanged
+static int _chm_equal(const void* a, const void* b, size_t len){
+    atomic_thread_fence(memory_order_acquire);
+    if(atomic_load_explicit(_chm_reader.seq, memory_order_relaxed) != _chm_reader.start)
+        return 0; // result is thrown away anyway
+    return _chm_reader.equal(a, b, len);
+}
+
+// one record per thread that ever read, they are never freed, records of exited threads get reused
+typedef struct _chm_rec_t {
+    _Alignas(64) _Atomic uint64_t epoch; // epoch the running read started in, 0 = not reading
+    _Atomic int used;
+    unsigned depth; // nested reads on owning thread, only the outer one publishes
+    struct _chm_rec_t* next;
+} _chm_rec_t;
+
+static _Atomic(_chm_rec_t*) _chm_recs; // push only list
+static _Atomic uint64_t _chm_epoch = 1;
+static pthread_once_t _chm_rec_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _chm_rec_key; // only for its destructor, which frees the record on thread exit
+static _Thread_local _chm_rec_t* _chm_self;
+
+static void _chm_rec_release(void* p){
+    _chm_rec_t* rec = (_chm_rec_t*)p;
+    atomic_store_explicit(&rec->epoch, 0, memory_order_relaxed);
+    atomic_store_explicit(&rec->used, 0, memory_order_release);
+}
+static void _chm_rec_key_init(void){
+    pthread_key_create(&_chm_rec_key, _chm_rec_release);
+}
+
+static _chm_rec_t* _chm_rec_claim(void){
+    pthread_once(&_chm_rec_once, _chm_rec_key_init);
+    _chm_rec_t* rec;
+    for(rec = atomic_load_explicit(&_chm_recs, memory_order_acquire); rec; rec = rec->next){
+        int expected = 0;
+        if(atomic_load_explicit(&rec->used, memory_order_relaxed) == 0 && atomic_compare_exchange_strong(&rec->used, &expected, 1))
+            break;
+    }
+    if(rec == NULL){
+        rec = (_chm_rec_t*)aligned_alloc(_Alignof(_chm_rec_t), sizeof(_chm_rec_t));
+        atomic_init(&rec->epoch, 0);
+        atomic_init(&rec->used, 1);
+        rec->next = atomic_load_explicit(&_chm_recs, memory_order_relaxed);
+        while(!atomic_compare_exchange_weak(&_chm_recs, &rec->next, rec));
+    }
+    rec->depth = 0;
+    pthread_setspecific(_chm_rec_key, rec);
+    _chm_self = rec;
+    return rec;
+}
+
+// publishes current epoch before any table pointer is loaded, the seq_cst fence pairs with the one in _chm_collect:
+// either the writer sees this epoch or this reader sees the arrays that replaced the retired ones
+static inline void _chm_read_begin(void){
+    _chm_rec_t* rec = _chm_self ? _chm_self : _chm_rec_claim();
+    if(rec->depth++) return;
+    atomic_store_explicit(&rec->epoch, atomic_load_explicit(&_chm_epoch, memory_order_acquire), memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+static inline void _chm_read_end(void){
+    _chm_rec_t* rec = _chm_self;
+    if(--rec->depth) return;
+    atomic_store_explicit(&rec->epoch, 0, memory_order_release);
+}
+
+static inline void _chm_pause(void){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline chm_shard_t* _chm_shard(chashmap_t* chm, size_t hash){
+    return chm->shards + (chm->nshards > 1 ? (uint64_t)hash >> chm->shift : 0);
+}
+
+static inline void _chm_write_begin(chm_shard_t* sh){
+    atomic_store_explicit(&sh->seq, atomic_load_explicit(&sh->seq, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+static inline void _chm_write_end(chm_shard_t* sh){
+    atomic_store_explicit(&sh->seq, atomic_load_explicit(&sh->seq, memory_order_relaxed) + 1, memory_order_release);
+}
+
+void chashmap_init(chashmap_t* chm, size_t nshards, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t)){
+    if(nshards == 0)
+        nshards = CHASHMAP_DEFAULT_SHARDS;
+    size_t n = 1;
+    unsigned bits = 0;
+    while(n < nshards){
+        n <<= 1;
+        bits++;
+    }
+    chm->nshards = n;
+    chm->shift = 64 - bits;
+    chm->_hash = hash_func ? hash_func : hashmap_hash;
+    chm->_equal = equal_func ? equal_func : _mem_equal;
+    chm->shards = (chm_shard_t*)aligned_alloc(_Alignof(chm_shard_t), n * sizeof(chm_shard_t));
+    for(size_t i = 0; i < n; i++){
+        chm_shard_t* sh = chm->shards + i;
+        atomic_init(&sh->seq, 0);
+        pthread_mutex_init(&sh->lock, NULL);
+        hashmap_init(&sh->hm, chm->_hash, chm->_equal);
+        sh->retired = NULL;
+        sh->nretired = 0;
+        sh->retired_cap = 0;
+    }
+}
+
+// p must already be unreachable from the shard table, epoch is the one it was replaced in
+static void _chm_retire(chm_shard_t* sh, void* p, uint64_t epoch){
+    if(p == NULL) return;
+    if(sh->nretired == sh->retired_cap){
+        sh->retired_cap = sh->retired_cap ? sh->retired_cap * 2 : 8;
+        sh->retired = (chm_retired_t*)realloc(sh->retired, sh->retired_cap * sizeof(chm_retired_t));
+    }
+    sh->retired[sh->nretired++] = (chm_retired_t){p, epoch};
+}
+
+// frees retired arrays of a locked shard that are older than the epoch of every running reader
+static void _chm_collect(chm_shard_t* sh){
+    if(sh->nretired == 0) return;
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t min = UINT64_MAX;
+    for(_chm_rec_t* rec = atomic_load_explicit(&_chm_recs, memory_order_acquire); rec; rec = rec->next){
+        uint64_t e = atomic_load_explicit(&rec->epoch, memory_order_relaxed);
+        if(e && e < min)
+            min = e;
+    }
+    size_t keep = 0;
+    for(size_t j = 0; j < sh->nretired; j++){
+        if(sh->retired[j].epoch < min)
+            free(sh->retired[j].ptr);
+        else
+            sh->retired[keep++] = sh->retired[j];
+    }
+    sh->nretired = keep;
+}
+
+void chashmap_reclaim(chashmap_t* chm){
+    if(chm == NULL || chm->shards == NULL) return;
+    for(size_t i = 0; i < chm->nshards; i++){
+        chm_shard_t* sh = chm->shards + i;
+        pthread_mutex_lock(&sh->lock);
+        _chm_collect(sh);
+        pthread_mutex_unlock(&sh->lock);
+    }
+}
+
+void chashmap_destroy(chashmap_t* chm){
+    if(chm == NULL || chm->shards == NULL) return;
+    for(size_t i = 0; i < chm->nshards; i++){
+        chm_shard_t* sh = chm->shards + i;
+        for(size_t j = 0; j < sh->nretired; j++) // no readers left, everything goes
+            free(sh->retired[j].ptr);
+        free(sh->retired);
+        hashmap_destroy(&sh->hm);
+        pthread_mutex_destroy(&sh->lock);
+    }
+    free(chm->shards);
+    chm->shards = NULL;
+    chm->nshards = 0;
+}
+
+// builds the bigger table off to the side, readers keep using the current one meanwhile.
+// when deleted slots are most of the load the table is cleaned in place instead, nothing gets retired
+static void _chm_maybe_grow(chm_shard_t* sh){
+    hashmap_t* hm = &sh->hm;
+    double load = _hashmap_max_load(hm);
+    if(hm->count + hm->_deleted + 1 < hm->cap * load) return;
+    int in_place = hm->cap && hm->count < hm->cap * load / 2;
+    size_t cap = hm->cap == 0 ? _HM_INIT_CAP : in_place ? hm->cap : hm->cap << 1;
+    hashmap_t next = *hm;
+    _hashmap_alloc(&next, cap);
+    next.count = 0;
+    for(size_t i = 0; i < hm->cap; i++){
+        if(_HM_CTRL_FULL(hm->ctrl[i]))
+            _hashmap_insert(&next, hm->items[i].key, hm->items[i].len, hm->items[i].value, hm->items[i].hash);
+    }
+    if(in_place){ // readers overlapping the copy see seq change and retry
+        _chm_write_begin(sh);
+        memcpy(hm->items, next.items, cap * sizeof(hm_item_t));
+        memcpy(hm->ctrl, next.ctrl, cap + _HM_GROUP_WIDTH);
+        hm->_deleted = 0;
+        _chm_write_end(sh);
+        free(next.items);
+        free(next.ctrl);
+        return;
+    }
+    void* old_items = hm->items;
+    void* old_ctrl = hm->ctrl;
+    _chm_write_begin(sh);
+    *hm = next;
+    _chm_write_end(sh);
+    uint64_t epoch = atomic_fetch_add(&_chm_epoch, 1); // readers from now on start in a newer epoch and cant see old arrays
+    _chm_retire(sh, old_items, epoch);
+    _chm_retire(sh, old_ctrl, epoch);
+    _chm_collect(sh);
+}
+
+// mode: 0 = set, 1 = tryadd, 2 = trychange
+static int _chm_write(chashmap_t* chm, const void* key, size_t len, void* value, int mode){
+    if(chm == NULL || key == NULL) return 0;
+    size_t hash = chm->_hash(key, len);
+    chm_shard_t* sh = _chm_shard(chm, hash);
+    pthread_mutex_lock(&sh->lock);
+    _chm_collect(sh);
+    hashmap_t* hm = &sh->hm;
+    size_t i = hm->items ? _hashmap_find(hm, key, len, hash) : _HM_NOT_FOUND;
+    int ret;
+    if(i != _HM_NOT_FOUND){
+        ret = mode == 2;
+        if(mode != 1)
+            __atomic_store_n(&hm->items[i].value, value, __ATOMIC_RELEASE); // one word, readers see old or new value
+    }else if(mode == 2){
+        ret = 0;
+    }else{
+        _chm_maybe_grow(sh);
+        _chm_write_begin(sh);
+        _hashmap_insert(hm, key, len, value, hash);
+        _chm_write_end(sh);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return ret;
+}
+
+int chashmap_set_n_(chashmap_t* chm, const void* key, size_t len, void* value){
+    return _chm_write(chm, key, len, value, 0);
+}
+int chashmap_tryadd_n_(chashmap_t* chm, const void* key, size_t len, void* value){
+    return _chm_write(chm, key, len, value, 1);
+}
+int chashmap_trychange_n_(chashmap_t* chm, const void* key, size_t len, void* value){
+    return _chm_write(chm, key, len, value, 2);
+}
+
+void* chashmap_get_n(chashmap_t* chm, const void* key, size_t len){
+    if(chm == NULL || key == NULL) return 0;
+    size_t hash = chm->_hash(key, len);
+    chm_shard_t* sh = _chm_shard(chm, hash);
+    hashmap_t snap;
+    snap._equal = _chm_equal;
+    _chm_reader.seq = &sh->seq;
+    _chm_reader.equal = chm->_equal;
+    _chm_read_begin();
+    void* value;
+    while(1){
+        uint64_t start = atomic_load_explicit(&sh->seq, memory_order_acquire);
+        if(start & 1){
+            _chm_pause();
+            continue;
+        }
+        snap.items = __atomic_load_n(&sh->hm.items, __ATOMIC_RELAXED);
+        snap.ctrl = __atomic_load_n(&sh->hm.ctrl, __ATOMIC_RELAXED);
+        snap.cap = __atomic_load_n(&sh->hm.cap, __ATOMIC_RELAXED);
+        atomic_thread_fence(memory_order_acquire);
+        if(atomic_load_explicit(&sh->seq, memory_order_relaxed) != start)
+            continue; // table pointers must belong together before probing them
+        value = 0;
+        if(snap.items == NULL)
+            break;
+        _chm_reader.start = start;
+        size_t i = _hashmap_find(&snap, key, len, hash);
+        if(i != _HM_NOT_FOUND)
+            value = __atomic_load_n(&snap.items[i].value, __ATOMIC_RELAXED);
+        atomic_thread_fence(memory_order_acquire);
+        if(atomic_load_explicit(&sh->seq, memory_order_relaxed) == start)
+            break;
+    }
+    _chm_read_end();
+    return value;
+}
+
+void* chashmap_remove_n(chashmap_t* chm, const void* key, size_t len){
+    if(chm == NULL || key == NULL) return 0;
+    size_t hash = chm->_hash(key, len);
+    chm_shard_t* sh = _chm_shard(chm, hash);
+    pthread_mutex_lock(&sh->lock);
+    _chm_collect(sh);
+    hashmap_t* hm = &sh->hm;
+    void* value = 0;
+    size_t i = hm->items ? _hashmap_find(hm, key, len, hash) : _HM_NOT_FOUND;
+    if(i != _HM_NOT_FOUND){
+        value = hm->items[i].value;
+        _chm_write_begin(sh);
+        _hashmap_erase_at(hm, i); // back to empty when no probe can have passed it, so few deleted slots pile up
+        _chm_write_end(sh);
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return value;
+}
+
+int chashmap_set_(chashmap_t* chm, const char* key, void* value){
+    return key ? chashmap_set_n_(chm, key, strlen(key), value) : 0;
+}
+int chashmap_tryadd_(chashmap_t* chm, const char* key, void* value){
+    return key ? chashmap_tryadd_n_(chm, key, strlen(key), value) : 0;
+}
+int chashmap_trychange_(chashmap_t* chm, const char* key, void* value){
+    return key ? chashmap_trychange_n_(chm, key, strlen(key), value) : 0;
+}
+void* chashmap_get(chashmap_t* chm, const char* key){
+    return key ? chashmap_get_n(chm, key, strlen(key)) : 0;
+}
+void* chashmap_remove(chashmap_t* chm, const char* key){
+    return key ? chashmap_remove_n(chm, key, strlen(key)) : 0;
+}
+
+size_t chashmap_count(chashmap_t* chm){
+    if(chm == NULL || chm->shards == NULL) return 0;
+    size_t count = 0;
+    for(size_t i = 0; i < chm->nshards; i++)
+        count += __atomic_load_n(&chm->shards[i].hm.count, __ATOMIC_RELAXED);
+    return count;
+}
+
+void chashmap_foreach(chashmap_t* chm, void (*fn) (const char* key, size_t len, void* value, void* ctx), void* ctx){
+    if(chm == NULL || chm->shards == NULL || fn == NULL) return;
+    for(size_t i = 0; i < chm->nshards; i++){
+        chm_shard_t* sh = chm->shards + i;
+        pthread_mutex_lock(&sh->lock);
+        hm_iter_t it = hashmap_iter(&sh->hm);
+        while(hashmap_iter_next(&it))
+            fn(it.key, it.len, it.value, ctx);
+        pthread_mutex_unlock(&sh->lock);
+    }
+}
+
+#endif
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// awarearray that can be shared between threads
+// cap is fixed at init, slots are handed out through per thread caches (cawarr_cache_t)
+// that refill from and spill to one shared lock-free free list, so most pushes/deletes touch no shared memory
+
+typedef struct cawarearray_t {
+    void* data;
+    size_t elem_size;
+    size_t cap;
+    _Atomic uint32_t* next; // free list links, index + 1 of next free slot, 0 = end
+    _Atomic uint64_t free_head; // (aba tag << 32) | (index + 1), 0 in low half = empty
+    _Atomic size_t bump; // slots from here on were never handed out, so they dont need to be on the free list
+} cawarearray_t;
+
+#define CAWARR_CACHE_CAP 64
+
+// one per thread per array, not shareable
+typedef struct cawarr_cache_t {
+    cawarearray_t* arr;
+    uint32_t count;
+    uint32_t slots[CAWARR_CACHE_CAP];
+} cawarr_cache_t;
+
+
+#define CAWARR_NO_INDEX  SIZE_MAX
+
+
+#ifndef rtolvalue
+#define rtolvalue(val) ((struct { typeof(val) _; }){val})
+#endif
+
+
+#define cawarr_as(arr, type)  ((type*)(arr)->data)
+#define cawarr_get(arr, index, type)  (cawarr_as(arr, type)[index])
+#define cawarr_getp(arr, index, type)  (cawarr_as(arr, type) + (index))
+#define cawarr_getraw(arr, index)  ((arr)->data + (index) * (arr)->elem_size)
+
+#define cawarr_push(cache, lval)  _cawarr_push(cache, (void*)&lval)
+#define cawarr_push_rval(cache, rval)  _cawarr_push(cache, (void*)&rtolvalue(rval))
+// returns index of slot elem was put into, CAWARR_NO_INDEX if array is full
+size_t _cawarr_push(cawarr_cache_t* cache, void* elem);
+void cawarr_delete(cawarr_cache_t* cache, size_t index);
+
+// cap must be < UINT32_MAX
+void cawarr_init(cawarearray_t* arr, size_t elem_size, size_t cap);
+void cawarr_free(cawarearray_t* arr);
+
+void cawarr_cache_init(cawarr_cache_t* cache, cawarearray_t* arr);
+// gives cached free slots back to shared list, call before thread stops using the array
+void cawarr_cache_flush(cawarr_cache_t* cache);
+
+
+#ifdef _CAWARR_IMPLEMENTATION_
+
+#define _CAWARR_BATCH (CAWARR_CACHE_CAP / 2)
+
+void cawarr_init(cawarearray_t* arr, size_t elem_size, size_t cap){
+    arr->elem_size = elem_size;
+    arr->cap = cap;
+    arr->data = malloc(cap * elem_size);
+    arr->next = (_Atomic uint32_t*)calloc(cap, sizeof(uint32_t));
+    atomic_init(&arr->free_head, 0);
+    atomic_init(&arr->bump, 0);
+}
+
+void cawarr_free(cawarearray_t* arr){
+    if(!arr) return;
+    if(arr->data)
+        free(arr->data);
+    if(arr->next)
+        free((void*)arr->next);
+}
+
+void cawarr_cache_init(cawarr_cache_t* cache, cawarearray_t* arr){
+    cache->arr = arr;
+    cache->count = 0;
+}
+
+// links slots into a chain and pushes it with one cas
+static void _cawarr_release_chain(cawarearray_t* arr, uint32_t* slots, uint32_t n){
+    if(n == 0) return;
+    for(uint32_t i = 0; i + 1 < n; i++){
+        atomic_store_explicit(&arr->next[slots[i]], slots[i + 1] + 1, memory_order_relaxed);
+    }
+    uint32_t last = slots[n - 1];
+    uint64_t head = atomic_load_explicit(&arr->free_head, memory_order_relaxed);
+    uint64_t new_head;
+    do{
+        atomic_store_explicit(&arr->next[last], (uint32_t)head, memory_order_relaxed);
+        new_head = (((head >> 32) + 1) << 32) | (slots[0] + 1);
+    }while(!atomic_compare_exchange_weak_explicit(&arr->free_head, &head, new_head, memory_order_release, memory_order_relaxed));
+}
+
+// pops up to max slots with one cas, the aba tag guarantees the walked chain was not changed in between
+static uint32_t _cawarr_acquire_chain(cawarearray_t* arr, uint32_t* out, uint32_t max){
+    uint64_t head = atomic_load_explicit(&arr->free_head, memory_order_acquire);
+    while(1){
+        uint32_t link = (uint32_t)head;
+        uint32_t n = 0;
+        while(link != 0 && n < max){
+            out[n++] = link - 1;
+            link = atomic_load_explicit(&arr->next[link - 1], memory_order_relaxed);
+        }
+        if(n == 0) return 0;
+        uint64_t new_head = (((head >> 32) + 1) << 32) | link;
+        if(atomic_compare_exchange_weak_explicit(&arr->free_head, &head, new_head, memory_order_acquire, memory_order_acquire))
+            return n;
+    }
+}
+
+static void _cawarr_refill(cawarr_cache_t* cache){
+    cawarearray_t* arr = cache->arr;
+    uint32_t n = _cawarr_acquire_chain(arr, cache->slots + cache->count, _CAWARR_BATCH);
+    cache->count += n;
+    if(n > 0) return;
+
+    if(atomic_load_explicit(&arr->bump, memory_order_relaxed) >= arr->cap) return;
+    size_t start = atomic_fetch_add_explicit(&arr->bump, _CAWARR_BATCH, memory_order_relaxed);
+    if(start >= arr->cap) return;
+    size_t end = start + _CAWARR_BATCH;
+    if(end > arr->cap) end = arr->cap;
+    for(size_t i = end; i > start; i--){ // reversed so slots come out in ascending order
+        cache->slots[cache->count++] = (uint32_t)(i - 1);
+    }
+}
+
+size_t _cawarr_push(cawarr_cache_t* cache, void* elem){
+    if(!cache || !elem) return CAWARR_NO_INDEX;
+    if(cache->count == 0){
+        _cawarr_refill(cache);
+        if(cache->count == 0) return CAWARR_NO_INDEX;
+    }
+    cawarearray_t* arr = cache->arr;
+    size_t index = cache->slots[--cache->count];
+
+    memcpy(cawarr_getraw(arr, index), elem, arr->elem_size);
+    return index;
+}
+
+void cawarr_delete(cawarr_cache_t* cache, size_t index){
+    if(!cache || index >= cache->arr->cap) return;
+    if(cache->count == CAWARR_CACHE_CAP){
+        cache->count -= _CAWARR_BATCH;
+        _cawarr_release_chain(cache->arr, cache->slots + cache->count, _CAWARR_BATCH);
+    }
+    cache->slots[cache->count++] = (uint32_t)index;
+}
+
+void cawarr_cache_flush(cawarr_cache_t* cache){
+    if(!cache) return;
+    _cawarr_release_chain(cache->arr, cache->slots, cache->count);
+    cache->count = 0;
+}
+
+#endif
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "hashmap.h"
+
+// read only snapshot of a hashmap_t, built on a minimal perfect hash (pthash style: keys go to small buckets,
+// every bucket gets a pilot that sends all its keys to free slots), so every lookup is exactly one slot probe
+// whole table is one flat buffer: header, pilots, slots, key bytes. offsets instead of pointers,
+// so it can be written to a file and mmaped back with no parsing, many processes can share the page cache copy
+// keys are hashed with hashmap_hash and compared bytewise, whatever hash/equal the source map used
+// values are stored as 64 bit words, pointers in them only mean something in the process that froze the map
+
+typedef struct fm_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t nbuckets;
+    uint64_t seed;
+    uint64_t range; // positions pilots hash into, count plus a little slack
+    uint64_t pilots_off; // uint32_t per bucket
+    uint64_t remap_off; // uint32_t per position past count, slot it was moved to
+    uint64_t slots_off; // fm_slot_t per key
+    uint64_t keys_off; // key bytes
+    uint64_t size; // whole buffer
+} fm_header_t;
+
+typedef struct fm_slot_t {
+    uint64_t hash;
+    uint64_t key_off; // from keys_off
+    uint64_t len;
+    uint64_t value;
+} fm_slot_t;
+
+typedef struct frozenmap_t {
+    const uint8_t* base;
+    size_t size;
+    const fm_header_t* _hdr;
+    const uint32_t* _pilots;
+    const uint32_t* _remap;
+    const fm_slot_t* _slots;
+    const char* _keys;
+    int _owner; // 0 = borrowed buffer, 1 = malloced, 2 = mmaped
+} frozenmap_t;
+
+// ok = 1, fail = 0 (out of memory or two keys with same 64 bit hash)
+int hashmap_freeze(hashmap_t* hm, frozenmap_t* fm);
+// uses buf as is, buf must stay valid and 8 byte aligned. ok = 1, malformed = 0
+int frozenmap_from_buffer(frozenmap_t* fm, const void* buf, size_t size);
+// ok = 1, fail = 0
+int frozenmap_write(const frozenmap_t* fm, const char* path);
+// maps file read only. ok = 1, fail or malformed = 0
+int frozenmap_load(frozenmap_t* fm, const char* path);
+void frozenmap_destroy(frozenmap_t* fm);
+
+size_t frozenmap_count(const frozenmap_t* fm);
+// exists = value, not exists = 0
+void* frozenmap_get_n(const frozenmap_t* fm, const void* key, size_t len);
+void* frozenmap_get(const frozenmap_t* fm, const char* key);
+
+
+#ifdef FROZENMAP_IMPLEMENTATION
+
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define _FM_MAGIC 0x315a4d46 // "FMZ1"
+#define _FM_VERSION 1
+#define _FM_BUCKET_SIZE 4 // average keys per bucket, more = smaller pilots array but slower build
+#define _FM_MAX_PILOT (1u << 22) // tries per bucket before giving up on seed
+#define _FM_MAX_SEEDS 16
+// range is count + count / _FM_SLACK. without slack the last buckets search for the last few free slots forever,
+// the ones that land past count get moved to the slots left free below it
+#define _FM_SLACK 64
+
+static inline uint64_t _fm_mix(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+// h scaled into [0, n), high 64 bits of h * n
+static inline uint64_t _fm_range(uint64_t h, uint64_t n){
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)(((unsigned __int128)h * n) >> 64);
+#else
+    uint64_t hh = h >> 32, hl = (uint32_t)h, nh = n >> 32, nl = (uint32_t)n;
+    uint64_t lh = hl * nh, hln = hh * nl;
+    uint64_t mid = ((hl * nl) >> 32) + (uint32_t)lh + (uint32_t)hln;
+    return hh * nh + (lh >> 32) + (hln >> 32) + (mid >> 32);
+#endif
+}
+
+// hashmap_hash output is already well mixed, high bits pick the bucket
+static inline uint64_t _fm_bucket(uint64_t hash, uint64_t nbuckets){
+    return _fm_range(hash, nbuckets);
+}
+
+// remixed so slot doesnt correlate with the bucket, a new seed only moves slots
+static inline uint64_t _fm_pos(uint64_t hash, uint64_t seed, uint32_t pilot, uint64_t n){
+    return _fm_range(_fm_mix(hash ^ ((seed + pilot) * 0x9e3779b97f4a7c15)), n);
+}
+
+static inline size_t _fm_align8(size_t n){
+    return (n + 7) & ~(size_t)7;
+}
+
+// finds pilots for every bucket, biggest buckets first while there is most room. ok = 1, this seed failed = 0
+// slot_of gets final slots, positions past n are remapped and recorded in remap
+static int _fm_place(const uint64_t* hashes, size_t n, size_t range, size_t nbuckets, uint64_t seed, uint32_t* pilots, uint32_t* remap, uint32_t* slot_of){
+    size_t* start = (size_t*)calloc(nbuckets + 1, sizeof(size_t));
+    size_t* keys = (size_t*)malloc(n * sizeof(size_t));
+    size_t* order = (size_t*)malloc(nbuckets * sizeof(size_t));
+    uint8_t* taken = (uint8_t*)calloc(range, 1);
+    int ok = start && keys && order && taken;
+    size_t max_size = 0;
+    if(ok){
+        // counting sort keys by bucket
+        for(size_t i = 0; i < n; i++)
+            start[_fm_bucket(hashes[i], nbuckets) + 1]++;
+        for(size_t b = 0; b < nbuckets; b++){
+            if(start[b + 1] > max_size)
+                max_size = start[b + 1];
+            start[b + 1] += start[b];
+        }
+        size_t* fill = order; // reused as cursor before it holds the order
+        memcpy(fill, start, nbuckets * sizeof(size_t));
+        for(size_t i = 0; i < n; i++)
+            keys[fill[_fm_bucket(hashes[i], nbuckets)]++] = i;
+        // buckets by size, descending
+        size_t* by_size = (size_t*)calloc(max_size + 2, sizeof(size_t));
+        ok = by_size != NULL;
+        if(ok){
+            for(size_t b = 0; b < nbuckets; b++)
+                by_size[max_size - (start[b + 1] - start[b]) + 1]++;
+            for(size_t s = 0; s <= max_size; s++)
+                by_size[s + 1] += by_size[s];
+            for(size_t b = 0; b < nbuckets; b++)
+                order[by_size[max_size - (start[b + 1] - start[b])]++] = b;
+            free(by_size);
+        }
+    }
+    uint64_t* pos = ok ? (uint64_t*)malloc((max_size + 1) * sizeof(uint64_t)) : NULL;
+    ok = ok && pos;
+
+    for(size_t o = 0; ok && o < nbuckets; o++){
+        size_t b = order[o];
+        size_t size = start[b + 1] - start[b];
+        const size_t* bk = keys + start[b];
+        pilots[b] = 0;
+        if(size == 0) continue;
+        uint32_t pilot = 0;
+        for(; pilot < _FM_MAX_PILOT; pilot++){
+            size_t j = 0;
+            for(; j < size; j++){
+                pos[j] = _fm_pos(hashes[bk[j]], seed, pilot, range);
+                if(taken[pos[j]]) break;
+                size_t k = 0;
+                while(k < j && pos[k] != pos[j])
+                    k++;
+                if(k < j) break;
+            }
+            if(j == size) break;
+        }
+        if(pilot == _FM_MAX_PILOT){
+            ok = 0;
+            break;
+        }
+        pilots[b] = pilot;
+        for(size_t j = 0; j < size; j++){
+            taken[pos[j]] = 1;
+            slot_of[bk[j]] = (uint32_t)pos[j];
+        }
+    }
+    // as many positions past n are taken as slots below n are free
+    size_t f = 0;
+    for(size_t p = n; ok && p < range; p++){
+        remap[p - n] = 0;
+        if(!taken[p]) continue;
+        while(taken[f])
+            f++;
+        taken[f] = 1;
+        remap[p - n] = (uint32_t)f;
+    }
+    for(size_t i = 0; ok && i < n; i++)
+        if(slot_of[i] >= n)
+            slot_of[i] = remap[slot_of[i] - n];
+    free(pos);
+    free(start);
+    free(keys);
+    free(order);
+    free(taken);
+    return ok;
+}
+
+int hashmap_freeze(hashmap_t* hm, frozenmap_t* fm){
+    if(hm == NULL || fm == NULL) return 0;
+    memset(fm, 0, sizeof(frozenmap_t));
+    size_t n = hm->count;
+    if(n > UINT32_MAX) return 0;
+    size_t nbuckets = n / _FM_BUCKET_SIZE + 1;
+    size_t range = n + n / _FM_SLACK;
+
+    hm_item_t* items = (hm_item_t*)malloc((n ? n : 1) * sizeof(hm_item_t));
+    uint64_t* hashes = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+    uint32_t* slot_of = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    uint32_t* pilots = (uint32_t*)malloc(nbuckets * sizeof(uint32_t));
+    uint32_t* remap = (uint32_t*)malloc((range - n + 1) * sizeof(uint32_t));
+    int ok = items && hashes && slot_of && pilots && remap;
+    size_t key_bytes = 0;
+    if(ok){
+        hm_iter_t it = hashmap_iter(hm);
+        size_t i = 0;
+        while(i < n && hashmap_iter_next(&it)){
+            items[i].key = it.key;
+            items[i].len = it.len;
+            items[i].value = it.value;
+            hashes[i] = hashmap_hash(it.key, it.len);
+            key_bytes += it.len;
+            i++;
+        }
+    }
+
+    uint64_t seed = 0x5851f42d4c957f2dull;
+    int placed = 0;
+    for(int s = 0; ok && s < _FM_MAX_SEEDS; s++){
+        placed = _fm_place(hashes, n, range, nbuckets, seed, pilots, remap, slot_of);
+        if(placed) break;
+        seed = _fm_mix(seed + 1);
+    }
+    ok = ok && placed;
+
+    uint8_t* buf = NULL;
+    size_t pilots_off = _fm_align8(sizeof(fm_header_t));
+    size_t remap_off = pilots_off + nbuckets * sizeof(uint32_t);
+    size_t slots_off = _fm_align8(remap_off + (range - n) * sizeof(uint32_t));
+    size_t keys_off = slots_off + n * sizeof(fm_slot_t);
+    size_t size = _fm_align8(keys_off + key_bytes);
+    if(ok){
+        buf = (uint8_t*)calloc(size, 1);
+        ok = buf != NULL;
+    }
+    if(ok){
+        fm_header_t* hdr = (fm_header_t*)buf;
+        hdr->magic = _FM_MAGIC;
+        hdr->version = _FM_VERSION;
+        hdr->count = n;
+        hdr->nbuckets = nbuckets;
+        hdr->seed = seed;
+        hdr->range = range;
+        hdr->pilots_off = pilots_off;
+        hdr->remap_off = remap_off;
+        hdr->slots_off = slots_off;
+        hdr->keys_off = keys_off;
+        hdr->size = size;
+        memcpy(buf + pilots_off, pilots, nbuckets * sizeof(uint32_t));
+        memcpy(buf + remap_off, remap, (range - n) * sizeof(uint32_t));
+        fm_slot_t* slots = (fm_slot_t*)(buf + slots_off);
+        size_t koff = 0;
+        for(size_t i = 0; i < n; i++){
+            fm_slot_t* sl = slots + slot_of[i];
+            sl->hash = hashes[i];
+            sl->key_off = koff;
+            sl->len = items[i].len;
+            sl->value = (uint64_t)(uintptr_t)items[i].value;
+            memcpy(buf + keys_off + koff, items[i].key, items[i].len);
+            koff += items[i].len;
+        }
+        ok = frozenmap_from_buffer(fm, buf, size);
+        fm->_owner = 1;
+    }
+    if(!ok)
+        free(buf);
+    free(items);
+    free(hashes);
+    free(slot_of);
+    free(pilots);
+    free(remap);
+    return ok;
+}
+
+int frozenmap_from_buffer(frozenmap_t* fm, const void* buf, size_t size){
+    if(fm == NULL || buf == NULL || size < sizeof(fm_header_t) || ((uintptr_t)buf & 7)) return 0;
+    const fm_header_t* hdr = (const fm_header_t*)buf;
+    if(hdr->magic != _FM_MAGIC || hdr->version != _FM_VERSION || hdr->size > size) return 0;
+    if(hdr->nbuckets == 0 || hdr->count > UINT32_MAX) return 0;
+    if(hdr->pilots_off < sizeof(fm_header_t) || (hdr->pilots_off & 7) || (hdr->slots_off & 7)) return 0;
+    if(hdr->range < hdr->count || hdr->range - hdr->count > hdr->count) return 0;
+    if(hdr->nbuckets > (hdr->size - hdr->pilots_off) / sizeof(uint32_t) || hdr->remap_off != hdr->pilots_off + hdr->nbuckets * sizeof(uint32_t)) return 0;
+    if(hdr->slots_off < hdr->remap_off + (hdr->range - hdr->count) * sizeof(uint32_t)) return 0;
+    if(hdr->slots_off > hdr->size || hdr->count > (hdr->size - hdr->slots_off) / sizeof(fm_slot_t)) return 0;
+    if(hdr->keys_off != hdr->slots_off + hdr->count * sizeof(fm_slot_t)) return 0;
+    fm->base = (const uint8_t*)buf;
+    fm->size = (size_t)hdr->size;
+    fm->_hdr = hdr;
+    fm->_pilots = (const uint32_t*)(fm->base + hdr->pilots_off);
+    fm->_remap = (const uint32_t*)(fm->base + hdr->remap_off);
+    fm->_slots = (const fm_slot_t*)(fm->base + hdr->slots_off);
+    fm->_keys = (const char*)(fm->base + hdr->keys_off);
+    fm->_owner = 0;
+    return 1;
+}
+
+int frozenmap_write(const frozenmap_t* fm, const char* path){
+    if(fm == NULL || fm->base == NULL || path == NULL) return 0;
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) return 0;
+    int ok = fwrite(fm->base, 1, fm->size, f) == fm->size;
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+int frozenmap_load(frozenmap_t* fm, const char* path){
+    if(fm == NULL || path == NULL) return 0;
+    memset(fm, 0, sizeof(frozenmap_t));
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(fm_header_t)){
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    void* p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return 0;
+    if(!frozenmap_from_buffer(fm, p, size)){
+        munmap(p, size);
+        memset(fm, 0, sizeof(frozenmap_t));
+        return 0;
+    }
+    fm->size = size; // whole mapping, for munmap
+    fm->_owner = 2;
+    return 1;
+}
+
+void frozenmap_destroy(frozenmap_t* fm){
+    if(fm == NULL) return;
+    if(fm->_owner == 1)
+        free((void*)fm->base);
+    else if(fm->_owner == 2)
+        munmap((void*)fm->base, fm->size);
+    memset(fm, 0, sizeof(frozenmap_t));
+}
+
+size_t frozenmap_count(const frozenmap_t* fm){
+    return fm && fm->_hdr ? (size_t)fm->_hdr->count : 0;
+}
+
+void* frozenmap_get_n(const frozenmap_t* fm, const void* key, size_t len){
+    if(fm == NULL || fm->_hdr == NULL || key == NULL || fm->_hdr->count == 0) return 0;
+    const fm_header_t* hdr = fm->_hdr;
+    uint64_t hash = hashmap_hash(key, len);
+    uint32_t pilot = fm->_pilots[_fm_bucket(hash, hdr->nbuckets)];
+    uint64_t pos = _fm_pos(hash, hdr->seed, pilot, hdr->range);
+    if(pos >= hdr->count){
+        pos = fm->_remap[pos - hdr->count];
+        if(pos >= hdr->count) return 0; // only on a damaged buffer
+    }
+    const fm_slot_t* sl = fm->_slots + pos;
+    // keys not in map land on some slot too, hash and bytes tell them apart
+    if(sl->hash != hash || sl->len != len || sl->key_off > hdr->size - hdr->keys_off || len > hdr->size - hdr->keys_off - sl->key_off)
+        return 0;
+    if(memcmp(fm->_keys + sl->key_off, key, len) != 0)
+        return 0;
+    return (void*)(uintptr_t)sl->value;
+}
+
+void* frozenmap_get(const frozenmap_t* fm, const char* key){
+    return key ? frozenmap_get_n(fm, key, strlen(key)) : 0;
+}
+
+#endif
@@ -1,354 +1,954 @@
-#pragma once
-
-#include <stdlib.h>
-
-typedef struct hm_item_t {
-    char* key;
-    void* value;
-#ifdef HASHMAP_TOMBSTONES
-    char deleted; // becomes 1 when removed and gets skipped when searching for element
-#endif
-} hm_item_t;
-
-typedef struct hashmap_t {
-    hm_item_t* items;
-    size_t count;
-    size_t cap; //must be power of 2
-
-    size_t (*_hash) (char*); // hash function
-    int (*_equal) (char*, char*); // equal function
-} hashmap_t;
-
-typedef struct hm_iter_t {
-    char* key;
-    void* value;
-    hashmap_t* _hm;
-    size_t _index;
-} hm_iter_t;
-
-void hashmap_init(hashmap_t* hm, size_t (*hash_func) (char*), int (*equal_func) (char*, char*));
-void hashmap_init_c(hashmap_t* hm);
-// added = 1, changed(existed) = 0
-int hashmap_set_(hashmap_t* hm, char* key, void* value);
-// adds only if not existed. added = 1, existed = 0
-int hashmap_tryadd_(hashmap_t* hm, char* key, void* value);
-// changes only if existed. changed = 1, not existed = 0
-int hashmap_trychange_(hashmap_t* hm, char* key, void* value);
-// exists = key, not exists = 0
-void* hashmap_get(hashmap_t* hm, char* key);
-// removed(existed) = key, not exists = 0
-void* hashmap_remove(hashmap_t* hm, char* key);
-
-void hashmap_clear(hashmap_t* hm);
-void hashmap_destroy(hashmap_t* hm);
-
-hm_iter_t hashmap_iter(hashmap_t* hm);
-int hashmap_iter_next(hm_iter_t* it);
-
-#define hashmap_set(hm, key, value)       hashmap_set_(hm, key, (void*)value) 
-#define hashmap_tryadd(hm, key, value)    hashmap_tryadd_(hm, key, (void*)value) 
-#define hashmap_trychange(hm, key, value) hashmap_trychange_(hm, key, (void*)value) 
-// #define hashmap_geti(hm, key)              (size_t)hashmap_get(hm, key) 
-// #define hashmap_removei(hm, key)           (size_t)hashmap_remove(hm, key) 
-
-
-#ifdef HASHMAP_IMPLEMENTATION
-
-#include <string.h>
-
-#define _SOME_PRIME 342049
-#define _HM_INIT_CAP (1 << 8)
-#define _HM_GROW_THRESHOLD 0.8
-
-#ifdef HASHMAP_TOMBSTONES
-#define _HM_NOT_TOMBSTONE(i) i.deleted == 0
-#define _HM_SET_TOMBSTONE(i, v) i.deleted = v
-#define _HM_GROUP(hm, i, hash)
-#else
-#define _HM_NOT_TOMBSTONE(i) 1
-#define _HM_SET_TOMBSTONE(i, v)
-#define _HM_GROUP(hm, i, hash) _hashmap_group(hm, i, hash);
-#endif
-
-//http://www.cse.yorku.ca/~oz/hash.html
-static size_t _djb2(char *str){
-    size_t hash = 5381;
-    int c;
-
-    while (c = *str++)
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-
-    return hash;
-}
-static int _str_equal(char* s1, char* s2){
-    return strcmp(s1, s2) == 0;
-}
-
-void hashmap_init(hashmap_t* hm, size_t (*hash_func) (char*), int (*equal_func) (char*, char*)){
-    hm->items = 0;
-    hm->count = 0;
-    hm->cap = 0;
-    hm->_hash = hash_func ? hash_func : _djb2;
-    hm->_equal = equal_func ? equal_func : _str_equal;
-}
-void hashmap_init_c(hashmap_t* hm){
-    hashmap_init(hm, _djb2, _str_equal);
-}
-
-static int _hashmap_set_unchecked(hashmap_t* hm, char* key, void* value){ // for expanding
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* items = hm->items;
-    while(1){
-        if(items[i].key == NULL){
-            items[i].key = key;
-            items[i].value = value;
-            // items[i].deleted = 0; //can skip zeroing it as we calloced items
-            hm->count++;
-            return 1;
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-static inline void hashmap_expand(hashmap_t* hm){
-    if(hm->cap == 0)
-        hm->cap = _HM_INIT_CAP;
-    else
-        hm->cap <<= 1;
-    hm_item_t* old = hm->items;
-    hm->items = (hm_item_t*)calloc(hm->cap, sizeof(hm_item_t));
-    if(old == NULL) return;
-    size_t count = hm->count;
-    hm->count = 0;
-    hm_item_t* oldit = old;
-    while(count){ // iterate until we find all keys, so to not iterate tail of NULLs
-        if(oldit->key != NULL && _HM_NOT_TOMBSTONE(oldit)){
-            _hashmap_set_unchecked(hm, oldit->key, oldit->value); //can use unchecked as we know keys wont repeat in past hashmap array
-            count--;
-        }
-        oldit++;
-    }
-    free(old);
-}
-
-static inline void hashmap_maybe_expand(hashmap_t* hm){
-    if(hm->count < hm->cap * _HM_GROW_THRESHOLD) return; // works for hm = {0}, as if wont return if cap is 0
-    hashmap_expand(hm);
-}
-
-int hashmap_set_(hashmap_t* hm, char* key, void* value){
-    if(hm == NULL || key == NULL) return 0;
-    hashmap_maybe_expand(hm);
-    
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* slot = NULL; //leave for not tombstones as it wont really change anything (fr wont change anything in actual optimizng compiler)
-    hm_item_t* items = hm->items;
-    while(1){
-        if(_HM_NOT_TOMBSTONE(items[i])){
-            if(items[i].key == NULL){
-                if(slot == NULL)
-                    slot = items + i;
-                slot->key = key;
-                slot->value = value;
-                _HM_SET_TOMBSTONE(slot, 0);
-                hm->count++;
-                return 1;
-            }
-            if(hm->_equal(items[i].key, key)){
-                items[i].value = value;
-                return 0;
-            }
-        }else if(slot == NULL)
-            slot = items + i;
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-int hashmap_tryadd_(hashmap_t* hm, char* key, void* value){
-    if(hm == NULL || key == NULL) return 0;
-    hashmap_maybe_expand(hm);
-    
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* slot = NULL; //leave for not tombstones as it wont really change anything (fr wont change anything in actual optimizng compiler)
-    hm_item_t* items = hm->items;
-    while(1){
-        if(_HM_NOT_TOMBSTONE(items[i])){
-            if(items[i].key == NULL){
-                if(slot == NULL)
-                    slot = items + i;
-                slot->key = key;
-                slot->value = value;
-                _HM_SET_TOMBSTONE(slot, 0);
-                hm->count++;
-                return 1;
-            }
-            if(hm->_equal(items[i].key, key))
-                return 0;
-        }else if(slot == NULL)
-            slot = items + i;
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-int hashmap_trychange_(hashmap_t* hm, char* key, void* value){
-    if(hm == NULL || key == NULL) return 0;
-    hashmap_maybe_expand(hm);
-    
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* items = hm->items;
-    while(1){
-        if(_HM_NOT_TOMBSTONE(items[i])){
-            if(items[i].key == NULL)
-                return 0;
-            if(hm->_equal(items[i].key, key)){
-                items[i].value = value;
-                return 1;
-            }
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-void* hashmap_get(hashmap_t* hm, char* key){
-    if(hm == NULL || hm->items == NULL || key == NULL) return 0;
-    //hashmap_maybe_expand(hm);
-
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* items = hm->items;
-    while(1){
-        if(_HM_NOT_TOMBSTONE(items[i])){
-            if(items[i].key == NULL)
-                return 0;
-            if(hm->_equal(items[i].key, key))
-                return items[i].value;
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-#ifndef HASHMAP_TOMBSTONES
-// shifts last collision element, so when finding them there were no holes between elements of same hash index
-static void _hashmap_group(hashmap_t* hm, size_t index, size_t hash){
-    size_t ihash;
-    size_t mask = hm->cap - 1;
-    size_t istart = hash & mask;
-    size_t i = (index + _SOME_PRIME) & mask;
-    size_t ilast = index;
-    while(1){
-        hm_item_t item = hm->items[i];
-        if(item.key == NULL){ //stop when encountering a hole
-            hm->items[index] = hm->items[ilast];
-            hm->items[ilast] = (hm_item_t){0, 0};
-            return;
-        }
-        ihash = hm->_hash(item.key);
-        if((ihash & mask) == istart){
-            ilast = i;
-        }
-        i = (i + _SOME_PRIME) & mask;
-    }
-}
-#endif
-
-void* hashmap_remove(hashmap_t* hm, char* key){
-    if(hm == NULL || hm->items == NULL || key == NULL) return 0;
-    //hashmap_maybe_expand(hm);
-
-    size_t hash = hm->_hash(key);
-    
-    size_t mask = hm->cap - 1;
-    size_t i = hash & mask;
-
-    hm_item_t* items = hm->items;
-    while(1){
-        if(_HM_NOT_TOMBSTONE(items[i])){
-            if(items[i].key == NULL)
-                return 0;
-            if(hm->_equal(items[i].key, key)){
-                void* value = items[i].value;
-                items[i].key = 0;
-                items[i].value = 0;
-                _HM_SET_TOMBSTONE(items[i], 1);
-                hm->count--;
-                _HM_GROUP(hm, i, hash);
-                return value;
-            }
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-
-    return 0;
-}
-
-void hashmap_clear(hashmap_t* hm){
-    if(hm == NULL) return;
-    if(hm->items)
-        memset(hm->items, 0, hm->cap * sizeof(hm_item_t));
-    hm->count = 0;
-}
-
-void hashmap_destroy(hashmap_t* hm){
-    if(hm == NULL) return;
-    if(hm->items)
-        free(hm->items);
-    hm->items = 0;
-    hm->count = 0;
-    hm->cap = 0;
-}
-
-
-hm_iter_t hashmap_iter(hashmap_t* hm){
-    if(hm == NULL || hm->items == NULL) return (hm_iter_t){0};
-    hm_iter_t it = {NULL, NULL, hm, 0};
-    return it;
-}
-
-int hashmap_iter_next(hm_iter_t* it){
-    if(it == NULL || it->_hm == NULL) return 0;
-
-    hashmap_t* hm = it->_hm;
-    hm_item_t* items = hm->items;
-    for(size_t i = it->_index; i < hm->cap; i++){
-        if(items[i].key != NULL && _HM_NOT_TOMBSTONE(items[i])){
-            it->key = items[i].key;
-            it->value = items[i].value;
-            it->_index= i + 1;
-            return 1;
-        }
-    }
-
-    it->_index = hm->cap;
-    return 0;
-}
-
-#endif
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef struct hm_item_t {
+    const char* key; // not owned, any len bytes, doesnt have to be 0 terminated
+    size_t len;
+    void* value;
+    size_t hash; // full key hash, so rehash and probing dont have to touch key memory
+} hm_item_t;
+
+#ifdef HASHMAP_STATS
+// probes are ctrl groups looked at (slots with HASHMAP_ROBINHOOD), 1 = found or given up in first one
+typedef struct hm_stats_t {
+    size_t lookups; // probe sequences, with HASHMAP_INCREMENTAL a key missing in new table is looked up in old one too
+    size_t hits;
+    size_t misses;
+    size_t hit_probes;
+    size_t miss_probes;
+    size_t max_probe;
+    size_t resizes; // rehashes, growing or in place
+    uint64_t resize_ns; // time spent in them, with HASHMAP_INCREMENTAL without the migration steps
+    size_t shifts; // robinhood entries moved by insert displacement or backward shift delete
+} hm_stats_t;
+#endif
+
+// swiss table layout: ctrl has one byte per slot, empty/deleted or 7 bits of the key hash when full
+// probes compare 16 ctrl bytes at once and only call _equal on tag matches
+// with HASHMAP_ROBINHOOD ctrl holds probe distance + 1 instead (0 = empty), probing is linear,
+// lookups stop once they are further from home than the slot they look at and removal shifts the run back
+typedef struct hashmap_t {
+    hm_item_t* items;
+    uint8_t* ctrl; // cap + 16 bytes, bytes past cap mirror the first ones so a group load never wraps (unused in robinhood)
+    size_t count;
+    size_t cap; //must be power of 2
+    size_t _deleted; // deleted ctrl bytes, they count towards load until next rehash
+    double _max_load; // grow threshold, 0 = default of the probing mode
+#ifdef HASHMAP_STATS
+    hm_stats_t _stats;
+#endif
+#ifdef HASHMAP_INCREMENTAL
+    // table being drained into this one, a few slots move on every write and lookups check both until it is empty
+    // count includes its entries
+    struct hashmap_t* _old;
+    size_t _migrate_pos;
+#endif
+
+    size_t (*_hash) (const void*, size_t); // hash function
+    int (*_equal) (const void*, const void*, size_t); // equal function, only called for keys of same len
+} hashmap_t;
+
+typedef struct hm_iter_t {
+    const char* key;
+    size_t len;
+    void* value;
+    hashmap_t* _hm;
+    size_t _index;
+} hm_iter_t;
+
+void hashmap_init(hashmap_t* hm, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t));
+void hashmap_init_c(hashmap_t* hm);
+
+// default hash, wyhash
+size_t hashmap_hash(const void* key, size_t len);
+
+// keys are len bytes at key, binary or slices of bigger buffers are fine, map keeps the pointer
+// added = 1, changed(existed) = 0
+int hashmap_set_n_(hashmap_t* hm, const void* key, size_t len, void* value);
+// adds only if not existed. added = 1, existed = 0
+int hashmap_tryadd_n_(hashmap_t* hm, const void* key, size_t len, void* value);
+// changes only if existed. changed = 1, not existed = 0
+int hashmap_trychange_n_(hashmap_t* hm, const void* key, size_t len, void* value);
+// exists = value, not exists = 0
+void* hashmap_get_n(hashmap_t* hm, const void* key, size_t len);
+// removed(existed) = value, not exists = 0
+void* hashmap_remove_n(hashmap_t* hm, const void* key, size_t len);
+
+// same for 0 terminated strings, key is strlen bytes
+int hashmap_set_(hashmap_t* hm, const char* key, void* value);
+int hashmap_tryadd_(hashmap_t* hm, const char* key, void* value);
+int hashmap_trychange_(hashmap_t* hm, const char* key, void* value);
+void* hashmap_get(hashmap_t* hm, const char* key);
+void* hashmap_remove(hashmap_t* hm, const char* key);
+
+// pointer to value of key, key gets added with value 0 if not existed (*inserted = 1, else 0, inserted can be NULL)
+// one hash and probe for read modify write, pointer is valid until next set/add/remove on map
+void** hashmap_entry_n(hashmap_t* hm, const void* key, size_t len, int* inserted);
+void** hashmap_entry(hashmap_t* hm, const char* key, int* inserted);
+// value = fn(current value or 0, existed, ctx). added = 1, changed(existed) = 0
+int hashmap_upsert_n(hashmap_t* hm, const void* key, size_t len, void* (*fn) (void* value, int existed, void* ctx), void* ctx);
+int hashmap_upsert(hashmap_t* hm, const char* key, void* (*fn) (void* value, int existed, void* ctx), void* ctx);
+
+// out_values[i] = hashmap_get of keys[i], returns how many exist. hashes a window of keys ahead and prefetches
+// their home slots, so the cache misses of many lookups overlap instead of being paid one after another.
+// lens can be NULL for NUL terminated keys, out_values is always fully written
+size_t hashmap_get_many_n(hashmap_t* hm, const void* const* keys, const size_t* lens, size_t n, void** out_values);
+size_t hashmap_get_many(hashmap_t* hm, const char* const* keys, size_t n, void** out_values);
+
+void hashmap_clear(hashmap_t* hm);
+void hashmap_destroy(hashmap_t* hm);
+
+// grows table so count entries fit without another rehash
+void hashmap_reserve(hashmap_t* hm, size_t count);
+// rehashes into smallest table that fits current entries, empty map frees its memory
+void hashmap_shrink_to_fit(hashmap_t* hm);
+// per map grow threshold, clamped to 0.25..0.95, 0 = default. takes effect on next insert
+void hashmap_set_max_load(hashmap_t* hm, double max_load);
+
+hm_iter_t hashmap_iter(hashmap_t* hm);
+int hashmap_iter_next(hm_iter_t* it);
+
+// walks table, hist[p] += entries that take p probes to find (last bucket collects longer ones), returns longest probe
+// probes counted as in hm_stats_t. hist must hold nbuckets zeroed counters, can be NULL to only get the max
+size_t hashmap_probe_histogram(hashmap_t* hm, size_t* hist, size_t nbuckets);
+
+#ifdef HASHMAP_STATS
+hm_stats_t hashmap_stats(hashmap_t* hm);
+void hashmap_stats_reset(hashmap_t* hm);
+#endif
+
+#define hashmap_set(hm, key, value)       hashmap_set_(hm, key, (void*)value) 
+#define hashmap_tryadd(hm, key, value)    hashmap_tryadd_(hm, key, (void*)value) 
+#define hashmap_trychange(hm, key, value) hashmap_trychange_(hm, key, (void*)value) 
+#define hashmap_set_n(hm, key, len, value)       hashmap_set_n_(hm, key, len, (void*)value)
+#define hashmap_tryadd_n(hm, key, len, value)    hashmap_tryadd_n_(hm, key, len, (void*)value)
+#define hashmap_trychange_n(hm, key, len, value) hashmap_trychange_n_(hm, key, len, (void*)value)
+// #define hashmap_geti(hm, key)              (size_t)hashmap_get(hm, key) 
+// #define hashmap_removei(hm, key)           (size_t)hashmap_remove(hm, key) 
+
+
+#ifdef HASHMAP_IMPLEMENTATION
+
+#include <string.h>
+
+#define _HM_INIT_CAP (1 << 8)
+#define _HM_MIN_CAP _HM_GROUP_WIDTH // ctrl mirrors need at least one full group
+#define _HM_GROUP_WIDTH 16
+
+#define _HM_NOT_FOUND SIZE_MAX
+#define _HM_BATCH 16 // lookups in flight for hashmap_get_many
+#define _HM_MIGRATE_STEP 32 // old slots looked at per write, table is drained long before new one can fill up
+
+#ifndef HASHMAP_ROBINHOOD
+#define _HM_GROW_THRESHOLD 0.875
+#define _HM_CTRL_EMPTY ((uint8_t)0x80)
+#define _HM_CTRL_DELETED ((uint8_t)0xfe)
+#define _HM_CTRL_FULL(c) ((c) < 0x80)
+#define _HM_H2(hash) ((uint8_t)((hash) & 0x7f)) // goes into ctrl
+#else
+#define _HM_GROW_THRESHOLD 0.9
+#define _HM_CTRL_EMPTY ((uint8_t)0)
+#define _HM_CTRL_FULL(c) ((c) != 0)
+#endif
+#define _HM_H1(hash) ((hash) >> 7) // picks home slot
+
+#ifdef HASHMAP_STATS
+#include <time.h>
+#define _HM_STAT(x) x
+static inline uint64_t _hm_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+static inline void _hm_stat_probe(hashmap_t* hm, int hit, size_t probes){
+    hm_stats_t* st = &hm->_stats;
+    st->lookups++;
+    if(hit){
+        st->hits++;
+        st->hit_probes += probes;
+    }else{
+        st->misses++;
+        st->miss_probes += probes;
+    }
+    if(probes > st->max_probe)
+        st->max_probe = probes;
+}
+#ifdef HASHMAP_INCREMENTAL
+static void _hm_stats_merge(hm_stats_t* dst, const hm_stats_t* src){
+    dst->lookups += src->lookups;
+    dst->hits += src->hits;
+    dst->misses += src->misses;
+    dst->hit_probes += src->hit_probes;
+    dst->miss_probes += src->miss_probes;
+    if(src->max_probe > dst->max_probe)
+        dst->max_probe = src->max_probe;
+    dst->resizes += src->resizes;
+    dst->resize_ns += src->resize_ns;
+    dst->shifts += src->shifts;
+}
+#endif
+#else
+#define _HM_STAT(x)
+#endif
+
+// group matchers, bit i of result is slot g + i
+#ifdef __SSE2__
+#include <emmintrin.h>
+static inline uint32_t _hm_match(const uint8_t* g, uint8_t h2){
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)g);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+static inline uint32_t _hm_match_empty(const uint8_t* g){
+    return _hm_match(g, _HM_CTRL_EMPTY);
+}
+#ifndef HASHMAP_ROBINHOOD
+static inline uint32_t _hm_match_free(const uint8_t* g){ // empty or deleted, both have high bit set
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g));
+}
+#else
+static inline uint32_t _hm_match_free(const uint8_t* g){
+    return _hm_match_empty(g);
+}
+#endif
+#else
+static inline uint32_t _hm_match(const uint8_t* g, uint8_t h2){
+    uint32_t m = 0;
+    for(int i = 0; i < _HM_GROUP_WIDTH; i++)
+        m |= (uint32_t)(g[i] == h2) << i;
+    return m;
+}
+static inline uint32_t _hm_match_empty(const uint8_t* g){
+    return _hm_match(g, _HM_CTRL_EMPTY);
+}
+static inline uint32_t _hm_match_free(const uint8_t* g){
+    uint32_t m = 0;
+    for(int i = 0; i < _HM_GROUP_WIDTH; i++)
+        m |= (uint32_t)!_HM_CTRL_FULL(g[i]) << i;
+    return m;
+}
+#endif
+
+//https://github.com/wangyi-fudan/wyhash, reads 8 bytes at a time and mixes with 64x64 -> 128 bit multiplies
+static inline void _hm_mum(uint64_t* a, uint64_t* b){
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+static inline uint64_t _hm_mix(uint64_t a, uint64_t b){
+    _hm_mum(&a, &b);
+    return a ^ b;
+}
+static inline uint64_t _hm_r8(const uint8_t* p){
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+static inline uint64_t _hm_r4(const uint8_t* p){
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+static inline uint64_t _hm_r3(const uint8_t* p, size_t k){
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+static const uint64_t _hm_secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+size_t hashmap_hash(const void* key, size_t len){
+    const uint8_t* p = (const uint8_t*)key;
+    uint64_t seed = _hm_mix(_hm_secret[0], _hm_secret[1]);
+    uint64_t a, b;
+    if(len <= 16){
+        if(len >= 4){
+            a = (_hm_r4(p) << 32) | _hm_r4(p + ((len >> 3) << 2));
+            b = (_hm_r4(p + len - 4) << 32) | _hm_r4(p + len - 4 - ((len >> 3) << 2));
+        }else if(len > 0){
+            a = _hm_r3(p, len);
+            b = 0;
+        }else{
+            a = b = 0;
+        }
+    }else{
+        size_t i = len;
+        if(i >= 48){
+            uint64_t see1 = seed, see2 = seed;
+            do{
+                seed = _hm_mix(_hm_r8(p) ^ _hm_secret[1], _hm_r8(p + 8) ^ seed);
+                see1 = _hm_mix(_hm_r8(p + 16) ^ _hm_secret[2], _hm_r8(p + 24) ^ see1);
+                see2 = _hm_mix(_hm_r8(p + 32) ^ _hm_secret[3], _hm_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            }while(i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while(i > 16){
+            seed = _hm_mix(_hm_r8(p) ^ _hm_secret[1], _hm_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _hm_r8(p + i - 16);
+        b = _hm_r8(p + i - 8);
+    }
+    a ^= _hm_secret[1];
+    b ^= seed;
+    _hm_mum(&a, &b);
+    return (size_t)_hm_mix(a ^ _hm_secret[0] ^ len, b ^ _hm_secret[1]);
+}
+static int _mem_equal(const void* a, const void* b, size_t len){
+    return memcmp(a, b, len) == 0;
+}
+
+void hashmap_init(hashmap_t* hm, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t)){
+    hm->items = 0;
+    hm->ctrl = 0;
+    hm->count = 0;
+    hm->cap = 0;
+    hm->_deleted = 0;
+    hm->_max_load = 0;
+#ifdef HASHMAP_STATS
+    memset(&hm->_stats, 0, sizeof(hm_stats_t));
+#endif
+#ifdef HASHMAP_INCREMENTAL
+    hm->_old = 0;
+    hm->_migrate_pos = 0;
+#endif
+    hm->_hash = hash_func ? hash_func : hashmap_hash;
+    hm->_equal = equal_func ? equal_func : _mem_equal;
+}
+void hashmap_init_c(hashmap_t* hm){
+    hashmap_init(hm, hashmap_hash, _mem_equal);
+}
+
+#ifndef HASHMAP_ROBINHOOD
+// writes ctrl byte and its mirror past cap
+static inline void _hashmap_set_ctrl(hashmap_t* hm, size_t i, uint8_t c){
+    hm->ctrl[i] = c;
+    hm->ctrl[((i - (_HM_GROUP_WIDTH - 1)) & (hm->cap - 1)) + (_HM_GROUP_WIDTH - 1)] = c;
+}
+
+// triangular probing over groups, visits every group once as cap is power of 2
+static size_t _hashmap_find(hashmap_t* hm, const void* key, size_t len, size_t hash){
+    size_t mask = hm->cap - 1;
+    size_t pos = _HM_H1(hash) & mask;
+    uint8_t h2 = _HM_H2(hash);
+    for(size_t step = _HM_GROUP_WIDTH; ; step += _HM_GROUP_WIDTH){
+        const uint8_t* g = hm->ctrl + pos;
+        for(uint32_t m = _hm_match(g, h2); m; m &= m - 1){
+            size_t i = (pos + __builtin_ctz(m)) & mask;
+            hm_item_t* item = hm->items + i;
+            if(item->hash == hash && item->len == len && hm->_equal(item->key, key, len)){
+                _HM_STAT(_hm_stat_probe(hm, 1, step / _HM_GROUP_WIDTH));
+                return i;
+            }
+        }
+        if(_hm_match_empty(g)){
+            _HM_STAT(_hm_stat_probe(hm, 0, step / _HM_GROUP_WIDTH));
+            return _HM_NOT_FOUND;
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+// first empty or deleted slot on key probe sequence
+static size_t _hashmap_find_free(hashmap_t* hm, size_t hash){
+    size_t mask = hm->cap - 1;
+    size_t pos = _HM_H1(hash) & mask;
+    for(size_t step = _HM_GROUP_WIDTH; ; step += _HM_GROUP_WIDTH){
+        uint32_t m = _hm_match_free(hm->ctrl + pos);
+        if(m)
+            return (pos + __builtin_ctz(m)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+// key must not be in map, returns its slot
+static size_t _hashmap_insert(hashmap_t* hm, const void* key, size_t len, void* value, size_t hash){
+    size_t i = _hashmap_find_free(hm, hash);
+    if(hm->ctrl[i] == _HM_CTRL_DELETED)
+        hm->_deleted--;
+    _hashmap_set_ctrl(hm, i, _HM_H2(hash));
+    hm->items[i].key = (const char*)key;
+    hm->items[i].len = len;
+    hm->items[i].value = value;
+    hm->items[i].hash = hash;
+    hm->count++;
+    return i;
+}
+
+// slot can go back to empty only if no probe ever saw a full group around it,
+// otherwise some probe may have passed through it and it has to stay deleted
+static void _hashmap_erase_at(hashmap_t* hm, size_t i){
+    size_t mask = hm->cap - 1;
+    uint32_t empty_before = _hm_match_empty(hm->ctrl + ((i - _HM_GROUP_WIDTH) & mask));
+    uint32_t empty_after = _hm_match_empty(hm->ctrl + i);
+    int was_never_full = empty_before && empty_after &&
+        (size_t)(__builtin_ctz(empty_after) + __builtin_clz(empty_before << (32 - _HM_GROUP_WIDTH))) < _HM_GROUP_WIDTH;
+    if(was_never_full){
+        _hashmap_set_ctrl(hm, i, _HM_CTRL_EMPTY);
+    }else{
+        _hashmap_set_ctrl(hm, i, _HM_CTRL_DELETED);
+        hm->_deleted++;
+    }
+    hm->items[i].key = 0;
+    hm->items[i].len = 0;
+    hm->items[i].value = 0;
+    hm->count--;
+}
+#else
+// distance + 1 of slot i, ctrl saturates at 255 and longer ones are recomputed from the cached hash
+static inline size_t _hashmap_dist(hashmap_t* hm, size_t i){
+    uint8_t c = hm->ctrl[i];
+    if(c < UINT8_MAX)
+        return c;
+    size_t mask = hm->cap - 1;
+    return ((i - (_HM_H1(hm->items[i].hash) & mask)) & mask) + 1;
+}
+#define _HM_DIST_CTRL(d) ((uint8_t)((d) < UINT8_MAX ? (d) : UINT8_MAX))
+
+// entries of a run are sorted by distance, so once ours is larger than the slot's the key cant be further on
+static size_t _hashmap_find(hashmap_t* hm, const void* key, size_t len, size_t hash){
+    size_t mask = hm->cap - 1;
+    size_t i = _HM_H1(hash) & mask;
+    for(size_t d = 1; ; d++){
+        size_t c = _hashmap_dist(hm, i);
+        if(c < d){
+            _HM_STAT(_hm_stat_probe(hm, 0, d));
+            return _HM_NOT_FOUND;
+        }
+        hm_item_t* item = hm->items + i;
+        if(c == d && item->hash == hash && item->len == len && hm->_equal(item->key, key, len)){
+            _HM_STAT(_hm_stat_probe(hm, 1, d));
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+// key must not be in map, returns its slot. takes slots from entries closer to their home and carries them on
+static size_t _hashmap_insert(hashmap_t* hm, const void* key, size_t len, void* value, size_t hash){
+    hm_item_t item = {(const char*)key, len, value, hash};
+    size_t mask = hm->cap - 1;
+    size_t i = _HM_H1(hash) & mask;
+    size_t at = SIZE_MAX; // where key landed, later steps only move displaced entries
+    for(size_t d = 1; ; d++){
+        size_t c = _hashmap_dist(hm, i);
+        if(c == 0){
+            hm->ctrl[i] = _HM_DIST_CTRL(d);
+            hm->items[i] = item;
+            hm->count++;
+            return at == SIZE_MAX ? i : at;
+        }
+        if(c < d){
+            if(at == SIZE_MAX)
+                at = i;
+            _HM_STAT(hm->_stats.shifts++);
+            hm_item_t tmp = hm->items[i];
+            hm->items[i] = item;
+            item = tmp;
+            hm->ctrl[i] = _HM_DIST_CTRL(d);
+            d = c;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+// backward shift, pulls following entries of the run one slot closer to home
+static void _hashmap_erase_at(hashmap_t* hm, size_t i){
+    size_t mask = hm->cap - 1;
+    size_t next = (i + 1) & mask;
+    size_t d;
+    while((d = _hashmap_dist(hm, next)) > 1){
+        _HM_STAT(hm->_stats.shifts++);
+        hm->items[i] = hm->items[next];
+        hm->ctrl[i] = _HM_DIST_CTRL(d - 1);
+        i = next;
+        next = (next + 1) & mask;
+    }
+    hm->ctrl[i] = _HM_CTRL_EMPTY;
+    hm->items[i].key = 0;
+    hm->items[i].len = 0;
+    hm->items[i].value = 0;
+    hm->count--;
+}
+#endif
+
+static void _hashmap_alloc(hashmap_t* hm, size_t cap){
+    hm->cap = cap;
+    hm->items = (hm_item_t*)malloc(cap * sizeof(hm_item_t));
+    hm->ctrl = (uint8_t*)malloc(cap + _HM_GROUP_WIDTH);
+    memset(hm->ctrl, _HM_CTRL_EMPTY, cap + _HM_GROUP_WIDTH);
+    hm->_deleted = 0;
+}
+
+#ifndef HASHMAP_INCREMENTAL
+// rebuilds table with new cap, also drops all deleted slots
+static void _hashmap_rehash(hashmap_t* hm, size_t cap){
+    hm_item_t* old = hm->items;
+    uint8_t* old_ctrl = hm->ctrl;
+    size_t old_cap = hm->cap;
+    _hashmap_alloc(hm, cap);
+    hm->count = 0;
+    if(old == NULL) return;
+    for(size_t i = 0; i < old_cap; i++){
+        if(!_HM_CTRL_FULL(old_ctrl[i])) continue;
+        _hashmap_insert(hm, old[i].key, old[i].len, old[i].value, old[i].hash); // keys wont repeat, no need to search
+    }
+    free(old);
+    free(old_ctrl);
+}
+
+static inline size_t _hashmap_live(hashmap_t* hm){
+    return hm->count;
+}
+
+// finds key, *table is set to the table its in
+static inline size_t _hashmap_lookup(hashmap_t* hm, const void* key, size_t len, size_t hash, hashmap_t** table){
+    *table = hm;
+    return _hashmap_find(hm, key, len, hash);
+}
+#else
+static void _hashmap_free_old(hashmap_t* hm){
+    hashmap_t* old = hm->_old;
+    if(old == NULL) return;
+    _HM_STAT(_hm_stats_merge(&hm->_stats, &old->_stats));
+    free(old->items);
+    free(old->ctrl);
+    free(old);
+    hm->_old = NULL;
+}
+
+// moves up to steps old slots worth of entries into the new table
+static void _hashmap_migrate(hashmap_t* hm, size_t steps){
+    hashmap_t* old = hm->_old;
+    if(old == NULL) return;
+    size_t mask = old->cap - 1;
+    while(steps-- && old->count){
+        size_t i = hm->_migrate_pos;
+        if(!_HM_CTRL_FULL(old->ctrl[i])){
+            hm->_migrate_pos = (i + 1) & mask;
+            continue;
+        }
+        hm_item_t item = old->items[i];
+        _hashmap_erase_at(old, i); // robinhood can shift next entry into i, so i is looked at again
+        _hashmap_insert(hm, item.key, item.len, item.value, item.hash);
+        hm->count--; // was already counted while in old table
+    }
+    if(old->count == 0)
+        _hashmap_free_old(hm);
+}
+
+// current table becomes old one and gets drained over the next writes
+static void _hashmap_rehash(hashmap_t* hm, size_t cap){
+    _hashmap_migrate(hm, SIZE_MAX); // only one old table at a time
+    if(hm->count == 0){
+        free(hm->items);
+        free(hm->ctrl);
+        _hashmap_alloc(hm, cap);
+        return;
+    }
+    hashmap_t* old = (hashmap_t*)malloc(sizeof(hashmap_t));
+    *old = *hm;
+    old->_old = NULL;
+    _HM_STAT(memset(&old->_stats, 0, sizeof(hm_stats_t))); // counts whats done on old table only, added back when its freed
+    _hashmap_alloc(hm, cap);
+    hm->_old = old;
+    hm->_migrate_pos = 0;
+}
+
+// entries in this table, without ones still waiting in old
+static inline size_t _hashmap_live(hashmap_t* hm){
+    return hm->count - (hm->_old ? hm->_old->count : 0);
+}
+
+// finds key in new table then in old one, *table is set to the table its in
+static inline size_t _hashmap_lookup(hashmap_t* hm, const void* key, size_t len, size_t hash, hashmap_t** table){
+    *table = hm;
+    size_t i = _hashmap_find(hm, key, len, hash);
+    if(i != _HM_NOT_FOUND || hm->_old == NULL)
+        return i;
+    *table = hm->_old;
+    return _hashmap_find(hm->_old, key, len, hash);
+}
+#endif
+
+static inline double _hashmap_max_load(hashmap_t* hm){
+    return hm->_max_load > 0 ? hm->_max_load : _HM_GROW_THRESHOLD;
+}
+
+static inline void hashmap_expand(hashmap_t* hm){
+    _hashmap_rehash(hm, hm->cap == 0 ? _HM_INIT_CAP : hm->cap << 1);
+}
+
+// deleted slots count as used, when they are most of the load rehash in place instead of growing
+static inline void hashmap_maybe_expand(hashmap_t* hm){
+#ifdef HASHMAP_INCREMENTAL
+    _hashmap_migrate(hm, _HM_MIGRATE_STEP);
+#endif
+    size_t live = _hashmap_live(hm);
+    double load = _hashmap_max_load(hm);
+    if(live + hm->_deleted + 1 < hm->cap * load) return; // +1 keeps an empty slot for lookups to stop at, works for hm = {0}
+    _HM_STAT(uint64_t t0 = _hm_now_ns());
+    if(live < hm->cap * load / 2)
+        _hashmap_rehash(hm, hm->cap);
+    else
+        hashmap_expand(hm);
+    _HM_STAT(hm->_stats.resizes++; hm->_stats.resize_ns += _hm_now_ns() - t0);
+}
+
+int hashmap_set_n_(hashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || key == NULL) return 0;
+    hashmap_maybe_expand(hm);
+
+    hashmap_t* t;
+    size_t hash = hm->_hash(key, len);
+    size_t i = _hashmap_lookup(hm, key, len, hash, &t);
+    if(i != _HM_NOT_FOUND){
+        t->items[i].value = value;
+        return 0;
+    }
+    _hashmap_insert(hm, key, len, value, hash);
+    return 1;
+}
+
+int hashmap_tryadd_n_(hashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || key == NULL) return 0;
+    hashmap_maybe_expand(hm);
+
+    hashmap_t* t;
+    size_t hash = hm->_hash(key, len);
+    if(_hashmap_lookup(hm, key, len, hash, &t) != _HM_NOT_FOUND)
+        return 0;
+    _hashmap_insert(hm, key, len, value, hash);
+    return 1;
+}
+
+int hashmap_trychange_n_(hashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || hm->items == NULL || key == NULL) return 0;
+
+    hashmap_t* t;
+    size_t i = _hashmap_lookup(hm, key, len, hm->_hash(key, len), &t);
+    if(i == _HM_NOT_FOUND)
+        return 0;
+    t->items[i].value = value;
+    return 1;
+}
+
+void* hashmap_get_n(hashmap_t* hm, const void* key, size_t len){
+    if(hm == NULL || hm->items == NULL || key == NULL) return 0;
+
+    hashmap_t* t;
+    size_t i = _hashmap_lookup(hm, key, len, hm->_hash(key, len), &t);
+    if(i == _HM_NOT_FOUND)
+        return 0;
+    return t->items[i].value;
+}
+
+void* hashmap_remove_n(hashmap_t* hm, const void* key, size_t len){
+    if(hm == NULL || hm->items == NULL || key == NULL) return 0;
+#ifdef HASHMAP_INCREMENTAL
+    _hashmap_migrate(hm, _HM_MIGRATE_STEP);
+#endif
+
+    hashmap_t* t;
+    size_t i = _hashmap_lookup(hm, key, len, hm->_hash(key, len), &t);
+    if(i == _HM_NOT_FOUND)
+        return 0;
+    void* value = t->items[i].value;
+    _hashmap_erase_at(t, i);
+    if(t != hm)
+        hm->count--;
+    return value;
+}
+
+void** hashmap_entry_n(hashmap_t* hm, const void* key, size_t len, int* inserted){
+    if(inserted) *inserted = 0;
+    if(hm == NULL || key == NULL) return NULL;
+    hashmap_maybe_expand(hm); // before the lookup, so the insert below cant move the found slot
+
+    hashmap_t* t;
+    size_t hash = hm->_hash(key, len);
+    size_t i = _hashmap_lookup(hm, key, len, hash, &t);
+    if(i != _HM_NOT_FOUND)
+        return &t->items[i].value;
+    i = _hashmap_insert(hm, key, len, NULL, hash);
+    if(inserted) *inserted = 1;
+    return &hm->items[i].value;
+}
+
+int hashmap_upsert_n(hashmap_t* hm, const void* key, size_t len, void* (*fn) (void* value, int existed, void* ctx), void* ctx){
+    if(fn == NULL) return 0;
+    int inserted;
+    void** value = hashmap_entry_n(hm, key, len, &inserted);
+    if(value == NULL) return 0;
+    *value = fn(*value, !inserted, ctx);
+    return inserted;
+}
+
+// only new table, with incremental resize old one drains quickly and is rarely probed
+static inline void _hashmap_prefetch(hashmap_t* hm, size_t hash){
+    size_t i = _HM_H1(hash) & (hm->cap - 1);
+    __builtin_prefetch(hm->ctrl + i);
+    __builtin_prefetch(hm->items + i);
+}
+
+// lens = NULL means keys are 0 terminated strings
+static size_t _hashmap_get_many(hashmap_t* hm, const void* const* keys, const size_t* lens, size_t n, void** out_values){
+    if(out_values == NULL) return 0;
+    if(hm == NULL || keys == NULL || hm->items == NULL){
+        memset(out_values, 0, n * sizeof(void*));
+        return 0;
+    }
+
+    size_t hashes[_HM_BATCH];
+    size_t klens[_HM_BATCH];
+    size_t found = 0;
+    for(size_t j = 0; j < n && j < _HM_BATCH; j++){
+        if(keys[j] == NULL) continue;
+        klens[j] = lens ? lens[j] : strlen((const char*)keys[j]);
+        hashes[j] = hm->_hash(keys[j], klens[j]);
+        _hashmap_prefetch(hm, hashes[j]);
+    }
+    for(size_t j = 0; j < n; j++){
+        size_t w = j % _HM_BATCH;
+        out_values[j] = 0;
+        if(keys[j] != NULL){
+            hashmap_t* t;
+            size_t i = _hashmap_lookup(hm, keys[j], klens[w], hashes[w], &t);
+            if(i != _HM_NOT_FOUND){
+                out_values[j] = t->items[i].value;
+                found++;
+            }
+        }
+        size_t next = j + _HM_BATCH; // slot w is free now, start on the key _HM_BATCH ahead
+        if(next < n && keys[next] != NULL){
+            klens[w] = lens ? lens[next] : strlen((const char*)keys[next]);
+            hashes[w] = hm->_hash(keys[next], klens[w]);
+            _hashmap_prefetch(hm, hashes[w]);
+        }
+    }
+    return found;
+}
+
+size_t hashmap_get_many_n(hashmap_t* hm, const void* const* keys, const size_t* lens, size_t n, void** out_values){
+    return _hashmap_get_many(hm, keys, lens, n, out_values);
+}
+size_t hashmap_get_many(hashmap_t* hm, const char* const* keys, size_t n, void** out_values){
+    return _hashmap_get_many(hm, (const void* const*)keys, NULL, n, out_values);
+}
+
+int hashmap_set_(hashmap_t* hm, const char* key, void* value){
+    return key ? hashmap_set_n_(hm, key, strlen(key), value) : 0;
+}
+int hashmap_tryadd_(hashmap_t* hm, const char* key, void* value){
+    return key ? hashmap_tryadd_n_(hm, key, strlen(key), value) : 0;
+}
+int hashmap_trychange_(hashmap_t* hm, const char* key, void* value){
+    return key ? hashmap_trychange_n_(hm, key, strlen(key), value) : 0;
+}
+void* hashmap_get(hashmap_t* hm, const char* key){
+    return key ? hashmap_get_n(hm, key, strlen(key)) : 0;
+}
+void* hashmap_remove(hashmap_t* hm, const char* key){
+    return key ? hashmap_remove_n(hm, key, strlen(key)) : 0;
+}
+void** hashmap_entry(hashmap_t* hm, const char* key, int* inserted){
+    if(key == NULL){
+        if(inserted) *inserted = 0;
+        return NULL;
+    }
+    return hashmap_entry_n(hm, key, strlen(key), inserted);
+}
+int hashmap_upsert(hashmap_t* hm, const char* key, void* (*fn) (void* value, int existed, void* ctx), void* ctx){
+    return key ? hashmap_upsert_n(hm, key, strlen(key), fn, ctx) : 0;
+}
+
+void hashmap_clear(hashmap_t* hm){
+    if(hm == NULL) return;
+#ifdef HASHMAP_INCREMENTAL
+    _hashmap_free_old(hm);
+#endif
+    if(hm->ctrl)
+        memset(hm->ctrl, _HM_CTRL_EMPTY, hm->cap + _HM_GROUP_WIDTH);
+    hm->count = 0;
+    hm->_deleted = 0;
+}
+
+void hashmap_destroy(hashmap_t* hm){
+    if(hm == NULL) return;
+#ifdef HASHMAP_INCREMENTAL
+    _hashmap_free_old(hm);
+#endif
+    if(hm->items)
+        free(hm->items);
+    if(hm->ctrl)
+        free(hm->ctrl);
+    hm->items = 0;
+    hm->ctrl = 0;
+    hm->count = 0;
+    hm->cap = 0;
+    hm->_deleted = 0;
+}
+
+
+// smallest power of 2 table that holds count entries under max load and still has an empty slot after them
+static size_t _hashmap_cap_for(hashmap_t* hm, size_t count){
+    double load = _hashmap_max_load(hm);
+    size_t cap = _HM_MIN_CAP;
+    while(cap * load < count + 1)
+        cap <<= 1;
+    return cap;
+}
+
+// rehash that is done when it returns, incremental mode drains old table right away
+static void _hashmap_resize_now(hashmap_t* hm, size_t cap){
+    _HM_STAT(uint64_t t0 = _hm_now_ns());
+    _hashmap_rehash(hm, cap);
+#ifdef HASHMAP_INCREMENTAL
+    _hashmap_migrate(hm, SIZE_MAX);
+#endif
+    _HM_STAT(hm->_stats.resizes++; hm->_stats.resize_ns += _hm_now_ns() - t0);
+}
+
+void hashmap_reserve(hashmap_t* hm, size_t count){
+    if(hm == NULL) return;
+    size_t cap = _hashmap_cap_for(hm, count);
+    if(cap > hm->cap)
+        _hashmap_resize_now(hm, cap);
+}
+
+void hashmap_shrink_to_fit(hashmap_t* hm){
+    if(hm == NULL || hm->items == NULL) return;
+    if(hm->count == 0){
+        hashmap_destroy(hm); // keeps hash/equal and max load, map stays usable
+        return;
+    }
+    size_t cap = _hashmap_cap_for(hm, hm->count);
+    if(cap < hm->cap || hm->_deleted)
+        _hashmap_resize_now(hm, cap < hm->cap ? cap : hm->cap);
+}
+
+void hashmap_set_max_load(hashmap_t* hm, double max_load){
+    if(hm == NULL) return;
+    if(max_load <= 0){
+        hm->_max_load = 0;
+        return;
+    }
+    hm->_max_load = max_load < 0.25 ? 0.25 : max_load > 0.95 ? 0.95 : max_load;
+}
+
+hm_iter_t hashmap_iter(hashmap_t* hm){
+    if(hm == NULL || hm->items == NULL) return (hm_iter_t){0};
+    hm_iter_t it = {NULL, 0, NULL, hm, 0};
+    return it;
+}
+
+// first full slot of t from i on, or t->cap. skips a group of non full slots per step
+static size_t _hashmap_next_full(hashmap_t* t, size_t i){
+    while(i < t->cap){
+        uint32_t full = ~_hm_match_free(t->ctrl + i) & ((1u << _HM_GROUP_WIDTH) - 1);
+        if(t->cap - i < _HM_GROUP_WIDTH)
+            full &= (1u << (t->cap - i)) - 1; // rest are mirrors
+        if(full)
+            return i + __builtin_ctz(full);
+        i += _HM_GROUP_WIDTH;
+    }
+    return t->cap;
+}
+
+// with HASHMAP_INCREMENTAL indexes past cap walk the old table
+int hashmap_iter_next(hm_iter_t* it){
+    if(it == NULL || it->_hm == NULL) return 0;
+
+    hashmap_t* t = it->_hm;
+    size_t base = 0;
+    size_t i = _hashmap_next_full(t, it->_index);
+#ifdef HASHMAP_INCREMENTAL
+    if(i == t->cap && t->_old){
+        base = t->cap;
+        t = t->_old;
+        i = _hashmap_next_full(t, it->_index > base ? it->_index - base : 0);
+    }
+#endif
+    if(i < t->cap){
+        it->key = t->items[i].key;
+        it->len = t->items[i].len;
+        it->value = t->items[i].value;
+        it->_index = base + i + 1;
+        return 1;
+    }
+
+    it->_index = base + t->cap;
+    return 0;
+}
+
+// probes a lookup of entry in slot i of t takes
+static size_t _hashmap_probe_len(hashmap_t* t, size_t i){
+#ifndef HASHMAP_ROBINHOOD
+    size_t mask = t->cap - 1;
+    size_t pos = _HM_H1(t->items[i].hash) & mask;
+    size_t probes = 1;
+    for(size_t step = _HM_GROUP_WIDTH; ((i - pos) & mask) >= _HM_GROUP_WIDTH; step += _HM_GROUP_WIDTH){
+        pos = (pos + step) & mask;
+        probes++;
+    }
+    return probes;
+#else
+    return _hashmap_dist(t, i);
+#endif
+}
+
+size_t hashmap_probe_histogram(hashmap_t* hm, size_t* hist, size_t nbuckets){
+    if(hm == NULL || hm->items == NULL) return 0;
+    size_t max = 0;
+    for(hashmap_t* t = hm; t; ){
+        for(size_t i = 0; i < t->cap; i++){
+            if(!_HM_CTRL_FULL(t->ctrl[i])) continue;
+            size_t p = _hashmap_probe_len(t, i);
+            if(p > max)
+                max = p;
+            if(hist && nbuckets)
+                hist[p < nbuckets ? p : nbuckets - 1]++;
+        }
+#ifdef HASHMAP_INCREMENTAL
+        t = t == hm ? hm->_old : NULL;
+#else
+        t = NULL;
+#endif
+    }
+    return max;
+}
+
+#ifdef HASHMAP_STATS
+hm_stats_t hashmap_stats(hashmap_t* hm){
+    hm_stats_t st = {0};
+    if(hm == NULL) return st;
+    st = hm->_stats;
+#ifdef HASHMAP_INCREMENTAL
+    if(hm->_old)
+        _hm_stats_merge(&st, &hm->_old->_stats);
+#endif
+    return st;
+}
+
+void hashmap_stats_reset(hashmap_t* hm){
+    if(hm == NULL) return;
+    memset(&hm->_stats, 0, sizeof(hm_stats_t));
+#ifdef HASHMAP_INCREMENTAL
+    if(hm->_old)
+        memset(&hm->_old->_stats, 0, sizeof(hm_stats_t));
+#endif
+}
+#endif
+
+#endif
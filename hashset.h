@@ -1,287 +1,653 @@
-#pragma once
-
-#include <stdlib.h>
-
-
-typedef struct hashset_t {
-    void** data;
-    size_t count;
-    size_t cap; // must be power of 2
-
-    size_t (*_hash) (size_t); // hash function
-    int (*_equal) (void*, void*); // equal function
-} hashset_t;
-
-typedef struct hs_iter_t {
-    void* value;
-    hashset_t* _hs;
-    size_t _index;
-} hs_iter_t;
-
-void hashset_init(hashset_t* hs, size_t (*hash_func) (size_t), int (*equal_func) (void*, void*));
-void hashset_init_c(hashset_t* hs);
-// added = 1, already exists = 0
-int hashset_add_(hashset_t* hs, void* val);
-// removed = 1, not exists = 0
-int hashset_remove_(hashset_t* hs, void* val);
-// exists = 1, not exists = 0
-int hashset_has_(hashset_t* hs, void* val);
-void hashset_clear(hashset_t* hs);
-void hashset_destroy(hashset_t* hs);
-
-#define hashset_add(hs, num)    hashset_add_(hs, (void*)num)
-#define hashset_remove(hs, num) hashset_remove_(hs, (void*)num)
-#define hashset_has(hs, num)    hashset_has_(hs, (void*)num)
-
-
-#ifdef HASHSET_IMPLEMENTATION
-
-#include <string.h>
-
-#define _SOME_PRIME 342049
-#define _HS_INIT_CAP (1 << 8)
-#define _HS_GROW_THRESHOLD 0.8
-
-#ifdef HASHSET_TOMBSTONES
-#define _HS_NOT_TOMBSTONE(i) i.deleted == 0
-#define _HS_SET_TOMBSTONE(i, v) i.deleted = v
-#else
-#define _HS_NOT_TOMBSTONE(i) 1
-#define _HS_SET_TOMBSTONE(i, v)
-#endif
-
-//http://zimbry.blogspot.com/2011/09/better-bit-mixing-improving-on.html
-static size_t _murmur3(size_t h) {
-  h ^= h >> 33;
-  h *= 0xff51afd7ed558ccd;
-  h ^= h >> 33;
-  h *= 0xc4ceb9fe1a85ec53;
-  h ^= h >> 33;
-  return h;
-}
-static int _equal(void* a, void* b){
-    return a == b;
-}
-
-//static size_t _hash(size_t val){
-//    size_t h = HS_HASH_FUNC(val);
-//    return h + (h == 0); // make sure its not 0
-//}
-
-void hashset_init(hashset_t* hs, size_t (*hash_func) (size_t), int (*equal_func) (void*, void*)){
-    hs->data = 0;
-    hs->count = 0;
-    hs->cap = 0;
-    hs->_hash = hash_func ? hash_func : _murmur3;
-    hs->_equal = equal_func ? equal_func : _equal;
-}
-void hashset_init_c(hashset_t* hs){
-    hashset_init(hs, _murmur3, _equal);
-}
-
-static int _hashset_add_unchecked(hashset_t* hs, void* val){
-    size_t sv = (size_t)val;
-    size_t hash = hs->_hash(sv);
-    
-    size_t mask = hs->cap - 1;
-    size_t i = hash & mask;
-
-    while(1){
-        if(hs->data[i] == NULL){
-            hs->data[i] = val;
-            hs->count++;
-            return 1;
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-    return 0;
-}
-
-static inline void hashset_expand(hashset_t* hs){
-    size_t cap = hs->cap;
-    //assert((cap & (cap - 1)) == 0); // assert its power of 2 (1 or 0 bits set total)
-    if(cap == 0) {
-        hs->cap = _HS_INIT_CAP;
-    } else { 
-        hs->cap <<= 1; // *= 2
-    }
-    void** old = hs->data;
-    hs->data = (void**)calloc(hs->cap + 1, sizeof(void*));
-    if(old == NULL) return;
-    size_t count = hs->count;
-    hs->count = 0;
-    void** oldit = old;
-    if(oldit[cap] != NULL){ //special case for 0/NULL
-        hs->data[hs->cap] = oldit[cap];
-        hs->count++;
-        count--;
-    }
-    while(count){ // iterate until we find all values, so to not iterate tail of NULLs
-        if(*oldit != NULL){
-            _hashset_add_unchecked(hs, *oldit); //can use unchecked as we know values wont repeat and we already handled 0/NULL case
-            count--;
-        }
-        oldit++;
-    }
-    free(old);
-}
-
-static inline void hashset_maybe_expand(hashset_t* hs){
-    if(hs->count < hs->cap * _HS_GROW_THRESHOLD) return; // works for hm = {0}, as if wont return if cap is 0
-    hashset_expand(hs);
-}
-
-int hashset_add_(hashset_t* hs, void* val){
-    if(hs == NULL) return 0;
-    hashset_maybe_expand(hs);
-    if(val == NULL){ //special case for 0/NULL
-        if(hs->data[hs->cap] != NULL)
-            return 0;
-        hs->data[hs->cap] = (void*)1;
-        hs->count++;
-        return 1;
-    }
-    
-    size_t sv = (size_t)val;
-    size_t hash = hs->_hash(sv);
-    
-    size_t mask = hs->cap - 1;
-    size_t i = hash & mask;
-
-    while(1){
-        if(hs->data[i] == NULL){
-            hs->data[i] = val;
-            hs->count++;
-            return 1;
-        }
-        if(hs->_equal(hs->data[i], val))
-            return 0;
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-    return 0;
-}
-
-// shifts last collision element, so when finding them there were no holes between elements of same hash index
-static void _hashset_group(hashset_t* hs, size_t index, size_t hash){
-    size_t ihash;
-    size_t mask = hs->cap - 1;
-    size_t istart = hash & mask;
-    size_t i = (index + _SOME_PRIME) & mask;
-    size_t ilast = index;
-    while(1){
-        void* val = hs->data[i];
-        if(val == NULL){ //stop when encountering a hole
-            hs->data[index] = hs->data[ilast];
-            hs->data[ilast] = 0;
-            return;
-        }
-        ihash = hs->_hash((size_t)val);
-        if((ihash & mask) == istart){
-            ilast = i;
-        }
-        i = (i + _SOME_PRIME) & mask;
-    }
-}
-
-int hashset_remove_(hashset_t* hs, void* val){
-    if(hs == NULL || hs->data == NULL || hs->count == 0) return 0;
-    //hashset_maybe_expand(hs);
-    if(val == NULL){ //special case for 0/NULL
-        if(hs->data[hs->cap] == NULL)
-            return 0;
-        hs->data[hs->cap] = NULL;
-        hs->count--;
-        return 1;
-    }
-
-    size_t sv = (size_t)val;
-    size_t hash = hs->_hash(sv);
-    
-    size_t mask = hs->cap - 1;
-    size_t i = hash & mask;
-
-    while(1){
-        if(hs->data[i] == NULL)
-            return 0;
-        if(hs->_equal(hs->data[i], val)){
-            hs->data[i] = 0;
-            hs->count--;
-            _hashset_group(hs, i, hash);
-            return 1;
-        }
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-    return 0;
-}
-
-int hashset_has_(hashset_t* hs, void* val){
-    if(hs == NULL || hs->data == NULL || hs->count == 0) return 0;
-    //hashset_maybe_expand(hs);
-    if(val == NULL){ //special case for 0/NULL
-        if(hs->data[hs->cap] == NULL)
-            return 0;
-        return 1;
-    }
-
-    size_t sv = (size_t)val;
-    size_t hash = hs->_hash(sv);
-    
-    size_t mask = hs->cap - 1;
-    size_t i = hash & mask;
-
-    while(1){
-        if(hs->data[i] == 0)
-            return 0;
-        if(hs->_equal(hs->data[i], val))
-            return 1;
-        i = (i + _SOME_PRIME) & mask; // calc next slot
-    }
-    return 0;
-}
-
-void hashset_clear(hashset_t* hs){
-    if(hs == NULL) return;
-    if(hs->data)
-        memset(hs->data, 0, (hs->cap + 1) * sizeof(void*));
-    hs->count = 0;
-}
-
-void hashset_destroy(hashset_t* hs){
-    if(hs == NULL) return;
-    if(hs->data)
-        free(hs->data);
-    hs->data = 0;
-    hs->count = 0;
-    hs->cap = 0;
-}
-
-
-hs_iter_t hashset_iter(hashset_t* hs) {
-    if(hs == NULL || hs->data == NULL) return (hs_iter_t){0};
-    hs_iter_t it = {NULL, hs, 0};
-    return it;
-}
-
-int hashset_iter_next(hs_iter_t* it){
-    if(it == NULL || it->_hs == NULL) return 0;
-
-    hashset_t* hs = it->_hs;
-    
-    for(size_t i = it->_index; i < hs->cap + 1; i++){
-        if(hs->data[i] != NULL){
-            if(i == hs->cap)
-                it->value = NULL; //special case for 0/NULL
-            else
-                it->value = hs->data[i];
-            it->_index = i + 1;
-            return 1;
-        }
-    }
-
-    it->_index = hs->cap + 1;
-    return 0;
-}
-
-
-// PS: i have yet to know how hashsets are actually implemented
-#endif
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef HASHSET_STATS
+// probes are slots looked at, 1 = found or given up on home slot. NULL value is not counted
+typedef struct hs_stats_t {
+    size_t lookups;
+    size_t hits;
+    size_t misses;
+    size_t hit_probes;
+    size_t miss_probes;
+    size_t max_probe;
+    size_t resizes;
+    uint64_t resize_ns; // time spent in rehashes
+    size_t shifts; // values moved by robinhood displacement and backward shift on remove
+} hs_stats_t;
+#endif
+
+// probing is linear and removal shifts the run back instead of leaving holes. data is 64 byte aligned so with
+// default equal a lookup compares a whole group of slots in one cache line at once (4 with avx2, 8 with avx512)
+// with HASHSET_ROBINHOOD _dist keeps probe distance + 1 per slot (0 = empty),
+// lookups stop once they are further from home than the slot they look at
+typedef struct hashset_t {
+    void** data;
+    size_t count;
+    size_t cap; // must be power of 2
+    double _max_load; // grow threshold, 0 = default of the probing mode
+#ifdef HASHSET_STATS
+    hs_stats_t _stats;
+#endif
+#ifdef HASHSET_ROBINHOOD
+    uint8_t* _dist; // cap bytes, saturates at 255, longer distances get recomputed from hash
+#endif
+
+    size_t (*_hash) (size_t); // hash function
+    int (*_equal) (void*, void*); // equal function
+} hashset_t;
+
+typedef struct hs_iter_t {
+    void* value;
+    hashset_t* _hs;
+    size_t _index;
+} hs_iter_t;
+
+void hashset_init(hashset_t* hs, size_t (*hash_func) (size_t), int (*equal_func) (void*, void*));
+void hashset_init_c(hashset_t* hs);
+// added = 1, already exists = 0
+int hashset_add_(hashset_t* hs, void* val);
+// removed = 1, not exists = 0
+int hashset_remove_(hashset_t* hs, void* val);
+// exists = 1, not exists = 0
+int hashset_has_(hashset_t* hs, void* val);
+// out[i] = hashset_has(vals[i]), returns how many exist. hashes a window of values ahead and prefetches
+// their slots, so the cache misses of many lookups overlap instead of being paid one after another
+size_t hashset_has_many(hashset_t* hs, void* const* vals, size_t n, uint8_t* out);
+void hashset_clear(hashset_t* hs);
+void hashset_destroy(hashset_t* hs);
+
+// grows table so count values fit without another rehash
+void hashset_reserve(hashset_t* hs, size_t count);
+// rehashes into smallest table that fits current values, empty set frees its memory
+void hashset_shrink_to_fit(hashset_t* hs);
+// per set grow threshold, clamped to 0.25..0.95, 0 = default. takes effect on next add
+void hashset_set_max_load(hashset_t* hs, double max_load);
+
+// walks table, hist[p] += values that take p probes to find (last bucket collects longer ones), returns longest probe
+// probes counted as in hs_stats_t. hist must hold nbuckets zeroed counters, can be NULL to only get the max
+size_t hashset_probe_histogram(hashset_t* hs, size_t* hist, size_t nbuckets);
+
+#ifdef HASHSET_STATS
+hs_stats_t hashset_stats(hashset_t* hs);
+void hashset_stats_reset(hashset_t* hs);
+#endif
+
+#define hashset_add(hs, num)    hashset_add_(hs, (void*)num)
+#define hashset_remove(hs, num) hashset_remove_(hs, (void*)num)
+#define hashset_has(hs, num)    hashset_has_(hs, (void*)num)
+
+
+#ifdef HASHSET_IMPLEMENTATION
+
+#include <string.h>
+
+#define _HS_INIT_CAP (1 << 8)
+#define _HS_MIN_CAP (1 << 3)
+#define _HS_BATCH 16 // lookups in flight for hashset_has_many
+#ifdef HASHSET_ROBINHOOD
+#define _HS_GROW_THRESHOLD 0.9
+#else
+#define _HS_GROW_THRESHOLD 0.8
+#endif
+
+#ifdef HASHSET_TOMBSTONES
+#define _HS_NOT_TOMBSTONE(i) i.deleted == 0
+#define _HS_SET_TOMBSTONE(i, v) i.deleted = v
+#else
+#define _HS_NOT_TOMBSTONE(i) 1
+#define _HS_SET_TOMBSTONE(i, v)
+#endif
+
+//http://zimbry.blogspot.com/2011/09/better-bit-mixing-improving-on.html
+static size_t _murmur3(size_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+static int _equal(void* a, void* b){
+    return a == b;
+}
+
+#ifndef HASHSET_ROBINHOOD
+// index of val or of first empty slot after home when not in set, compares pointers
+typedef size_t (*_hashset_scanop_t)(void* const* data, size_t mask, size_t home, void* val);
+
+static size_t _hashset_scan_scalar(void* const* data, size_t mask, size_t i, void* val){
+    while(data[i] != NULL && data[i] != val)
+        i = (i + 1) & mask;
+    return i;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define _HASHSET_X86
+#include <immintrin.h>
+
+// groups are aligned and cap is a multiple of the group, so they never cross a cache line or the NULL sentinel.
+// val lives between its home and the first empty slot, so any match in the group is it,
+// empties before home in the first group belong to other runs and are masked off
+__attribute__((target("avx2")))
+static size_t _hashset_scan_avx2(void* const* data, size_t mask, size_t home, void* val){
+    __m256i key = _mm256_set1_epi64x((long long)(size_t)val);
+    __m256i zero = _mm256_setzero_si256();
+    size_t g = home & ~(size_t)3;
+    unsigned live = ~0u << (home & 3);
+    while(1){
+        __m256i x = _mm256_load_si256((const __m256i*)(data + g));
+        unsigned eq = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, key)));
+        if(eq)
+            return g + __builtin_ctz(eq);
+        unsigned empty = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, zero))) & live;
+        if(empty)
+            return g + __builtin_ctz(empty);
+        live = ~0u;
+        g = (g + 4) & mask;
+    }
+}
+
+__attribute__((target("avx512f")))
+static size_t _hashset_scan_avx512(void* const* data, size_t mask, size_t home, void* val){
+    __m512i key = _mm512_set1_epi64((long long)(size_t)val);
+    size_t g = home & ~(size_t)7;
+    unsigned live = ~0u << (home & 7);
+    while(1){
+        __m512i x = _mm512_load_si512((const void*)(data + g));
+        unsigned eq = _mm512_cmpeq_epi64_mask(x, key);
+        if(eq)
+            return g + __builtin_ctz(eq);
+        unsigned empty = _mm512_testn_epi64_mask(x, x) & live;
+        if(empty)
+            return g + __builtin_ctz(empty);
+        live = ~0u;
+        g = (g + 8) & mask;
+    }
+}
+#endif
+
+static struct {
+    int ready; // 0 = not picked, 1 = picking, 2 = picked, only touched with __atomic ops
+    _hashset_scanop_t scan;
+} _hashset_kernels;
+
+// picks widest scan the cpu supports, once. safe to race on, first caller picks and publishes, others wait for it
+static void _hashset_dispatch(void){
+    if(__atomic_load_n(&_hashset_kernels.ready, __ATOMIC_ACQUIRE) == 2) return;
+    int expected = 0;
+    if(!__atomic_compare_exchange_n(&_hashset_kernels.ready, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+        while(__atomic_load_n(&_hashset_kernels.ready, __ATOMIC_ACQUIRE) != 2); // picking is short, spin
+        return;
+    }
+    _hashset_kernels.scan = _hashset_scan_scalar;
+#ifdef _HASHSET_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        _hashset_kernels.scan = _hashset_scan_avx2;
+    if(__builtin_cpu_supports("avx512f"))
+        _hashset_kernels.scan = _hashset_scan_avx512;
+#endif
+    __atomic_store_n(&_hashset_kernels.ready, 2, __ATOMIC_RELEASE);
+}
+#endif
+
+#ifdef HASHSET_STATS
+#include <time.h>
+#define _HS_STAT(x) x
+static inline uint64_t _hs_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+static inline void _hs_stat_probe(hashset_t* hs, int hit, size_t probes){
+    hs_stats_t* st = &hs->_stats;
+    st->lookups++;
+    if(hit){
+        st->hits++;
+        st->hit_probes += probes;
+    }else{
+        st->misses++;
+        st->miss_probes += probes;
+    }
+    if(probes > st->max_probe)
+        st->max_probe = probes;
+}
+#else
+#define _HS_STAT(x)
+#endif
+
+//static size_t _hash(size_t val){
+//    size_t h = HS_HASH_FUNC(val);
+//    return h + (h == 0); // make sure its not 0
+//}
+
+void hashset_init(hashset_t* hs, size_t (*hash_func) (size_t), int (*equal_func) (void*, void*)){
+    hs->data = 0;
+    hs->count = 0;
+    hs->cap = 0;
+    hs->_max_load = 0;
+#ifdef HASHSET_STATS
+    memset(&hs->_stats, 0, sizeof(hs_stats_t));
+#endif
+#ifdef HASHSET_ROBINHOOD
+    hs->_dist = 0;
+#endif
+    hs->_hash = hash_func ? hash_func : _murmur3;
+    hs->_equal = equal_func ? equal_func : _equal;
+#ifndef HASHSET_ROBINHOOD
+    _hashset_dispatch();
+#endif
+}
+void hashset_init_c(hashset_t* hs){
+    hashset_init(hs, _murmur3, _equal);
+}
+
+#ifdef HASHSET_ROBINHOOD
+static inline size_t _hashset_dist(hashset_t* hs, size_t i){
+    uint8_t c = hs->_dist[i];
+    if(c < UINT8_MAX)
+        return c;
+    size_t mask = hs->cap - 1;
+    return ((i - (hs->_hash((size_t)hs->data[i]) & mask)) & mask) + 1;
+}
+#define _HS_DIST_BYTE(d) ((uint8_t)((d) < UINT8_MAX ? (d) : UINT8_MAX))
+
+// takes slots from values closer to their home and carries them on
+static int _hashset_add_unchecked(hashset_t* hs, void* val){
+    size_t mask = hs->cap - 1;
+    size_t i = hs->_hash((size_t)val) & mask;
+    for(size_t d = 1; ; d++){
+        size_t c = _hashset_dist(hs, i);
+        if(c == 0){
+            hs->data[i] = val;
+            hs->_dist[i] = _HS_DIST_BYTE(d);
+            hs->count++;
+            return 1;
+        }
+        if(c < d){
+            _HS_STAT(hs->_stats.shifts++);
+            void* tmp = hs->data[i];
+            hs->data[i] = val;
+            val = tmp;
+            hs->_dist[i] = _HS_DIST_BYTE(d);
+            d = c;
+        }
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+// index of val or cap if not in set, runs are sorted by distance so it can stop early
+static size_t _hashset_find(hashset_t* hs, void* val, size_t hash){
+    size_t mask = hs->cap - 1;
+    size_t i = hash & mask;
+    for(size_t d = 1; ; d++){
+        size_t c = _hashset_dist(hs, i);
+        if(c < d){
+            _HS_STAT(_hs_stat_probe(hs, 0, d));
+            return hs->cap;
+        }
+        if(c == d && hs->_equal(hs->data[i], val)){
+            _HS_STAT(_hs_stat_probe(hs, 1, d));
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+}
+#else
+static int _hashset_add_unchecked(hashset_t* hs, void* val){
+    size_t mask = hs->cap - 1;
+    size_t i = hs->_hash((size_t)val) & mask;
+    while(hs->data[i] != NULL)
+        i = (i + 1) & mask;
+    hs->data[i] = val;
+    hs->count++;
+    return 1;
+}
+
+// slot of val, or first empty slot of its run when not in set
+static inline size_t _hashset_scan(hashset_t* hs, void* val, size_t hash){
+    size_t mask = hs->cap - 1;
+    size_t home = hash & mask;
+    size_t i;
+    if(hs->_equal == _equal){
+        i = _hashset_kernels.scan(hs->data, mask, home, val);
+    }else{
+        for(i = home; hs->data[i] != NULL && !hs->_equal(hs->data[i], val); i = (i + 1) & mask);
+    }
+    _HS_STAT(_hs_stat_probe(hs, hs->data[i] != NULL, ((i - home) & mask) + 1));
+    return i;
+}
+#endif
+
+// cap + 1 slots (last one is the NULL sentinel), zeroed and cache line aligned so scan groups stay in one line
+static void** _hashset_alloc(size_t cap){
+    size_t size = ((cap + 1) * sizeof(void*) + 63) & ~(size_t)63;
+    void** data = (void**)aligned_alloc(64, size);
+    memset(data, 0, size);
+    return data;
+}
+
+// cap must be power of 2 and fit all values
+static void _hashset_rehash(hashset_t* hs, size_t new_cap){
+    _HS_STAT(hs->_stats.resizes++);
+    _HS_STAT(uint64_t t0 = _hs_now_ns());
+    size_t cap = hs->cap;
+    hs->cap = new_cap;
+    void** old = hs->data;
+    hs->data = _hashset_alloc(hs->cap);
+#ifdef HASHSET_ROBINHOOD
+    free(hs->_dist);
+    hs->_dist = (uint8_t*)calloc(hs->cap, 1);
+#endif
+    if(old == NULL){
+        _HS_STAT(hs->_stats.resize_ns += _hs_now_ns() - t0);
+        return;
+    }
+    size_t count = hs->count;
+    hs->count = 0;
+    void** oldit = old;
+    if(oldit[cap] != NULL){ //special case for 0/NULL
+        hs->data[hs->cap] = oldit[cap];
+        hs->count++;
+        count--;
+    }
+    while(count){ // iterate until we find all values, so to not iterate tail of NULLs
+        if(*oldit != NULL){
+            _hashset_add_unchecked(hs, *oldit); //can use unchecked as we know values wont repeat and we already handled 0/NULL case
+            count--;
+        }
+        oldit++;
+    }
+    free(old);
+    _HS_STAT(hs->_stats.resize_ns += _hs_now_ns() - t0);
+}
+
+static inline void hashset_expand(hashset_t* hs){
+    //assert((cap & (cap - 1)) == 0); // assert its power of 2 (1 or 0 bits set total)
+    _hashset_rehash(hs, hs->cap == 0 ? _HS_INIT_CAP : hs->cap << 1);
+}
+
+static inline double _hashset_max_load(hashset_t* hs){
+    return hs->_max_load > 0 ? hs->_max_load : _HS_GROW_THRESHOLD;
+}
+
+static inline void hashset_maybe_expand(hashset_t* hs){
+    if(hs->count + 1 < hs->cap * _hashset_max_load(hs)) return; // +1 keeps an empty slot for lookups to stop at, works for hs = {0}
+    hashset_expand(hs);
+}
+
+int hashset_add_(hashset_t* hs, void* val){
+    if(hs == NULL) return 0;
+    hashset_maybe_expand(hs);
+    if(val == NULL){ //special case for 0/NULL
+        if(hs->data[hs->cap] != NULL)
+            return 0;
+        hs->data[hs->cap] = (void*)1;
+        hs->count++;
+        return 1;
+    }
+    
+#ifdef HASHSET_ROBINHOOD
+    if(_hashset_find(hs, val, hs->_hash((size_t)val)) != hs->cap)
+        return 0;
+    return _hashset_add_unchecked(hs, val);
+#else
+    size_t i = _hashset_scan(hs, val, hs->_hash((size_t)val));
+    if(hs->data[i] != NULL)
+        return 0;
+    hs->data[i] = val;
+    hs->count++;
+    return 1;
+#endif
+}
+
+#ifdef HASHSET_ROBINHOOD
+// backward shift, pulls following values of the run one slot closer to home
+static void _hashset_erase_at(hashset_t* hs, size_t i){
+    size_t mask = hs->cap - 1;
+    size_t next = (i + 1) & mask;
+    size_t d;
+    while((d = _hashset_dist(hs, next)) > 1){
+        _HS_STAT(hs->_stats.shifts++);
+        hs->data[i] = hs->data[next];
+        hs->_dist[i] = _HS_DIST_BYTE(d - 1);
+        i = next;
+        next = (next + 1) & mask;
+    }
+    hs->data[i] = 0;
+    hs->_dist[i] = 0;
+    hs->count--;
+}
+#else
+// backward shift, pulls later values of the run into the hole unless that would put them before their home
+static void _hashset_erase_at(hashset_t* hs, size_t i){
+    size_t mask = hs->cap - 1;
+    for(size_t j = (i + 1) & mask; hs->data[j] != NULL; j = (j + 1) & mask){
+        size_t home = hs->_hash((size_t)hs->data[j]) & mask;
+        if(((j - home) & mask) < ((j - i) & mask))
+            continue;
+        _HS_STAT(hs->_stats.shifts++);
+        hs->data[i] = hs->data[j];
+        i = j;
+    }
+    hs->data[i] = 0;
+    hs->count--;
+}
+#endif
+
+int hashset_remove_(hashset_t* hs, void* val){
+    if(hs == NULL || hs->data == NULL || hs->count == 0) return 0;
+    //hashset_maybe_expand(hs);
+    if(val == NULL){ //special case for 0/NULL
+        if(hs->data[hs->cap] == NULL)
+            return 0;
+        hs->data[hs->cap] = NULL;
+        hs->count--;
+        return 1;
+    }
+
+#ifdef HASHSET_ROBINHOOD
+    size_t i = _hashset_find(hs, val, hs->_hash((size_t)val));
+    if(i == hs->cap)
+        return 0;
+    _hashset_erase_at(hs, i);
+    return 1;
+#else
+    size_t i = _hashset_scan(hs, val, hs->_hash((size_t)val));
+    if(hs->data[i] == NULL)
+        return 0;
+    _hashset_erase_at(hs, i);
+    return 1;
+#endif
+}
+
+// val is not NULL, hash is hs->_hash(val)
+static int _hashset_has_hashed(hashset_t* hs, void* val, size_t hash){
+#ifdef HASHSET_ROBINHOOD
+    return _hashset_find(hs, val, hash) != hs->cap;
+#else
+    return hs->data[_hashset_scan(hs, val, hash)] != NULL;
+#endif
+}
+
+int hashset_has_(hashset_t* hs, void* val){
+    if(hs == NULL || hs->data == NULL || hs->count == 0) return 0;
+    //hashset_maybe_expand(hs);
+    if(val == NULL){ //special case for 0/NULL
+        if(hs->data[hs->cap] == NULL)
+            return 0;
+        return 1;
+    }
+    return _hashset_has_hashed(hs, val, hs->_hash((size_t)val));
+}
+
+static inline void _hashset_prefetch(hashset_t* hs, size_t hash){
+    size_t i = hash & (hs->cap - 1);
+    __builtin_prefetch(hs->data + i);
+#ifdef HASHSET_ROBINHOOD
+    __builtin_prefetch(hs->_dist + i);
+#endif
+}
+
+size_t hashset_has_many(hashset_t* hs, void* const* vals, size_t n, uint8_t* out){
+    if(hs == NULL || vals == NULL || out == NULL) return 0;
+    if(hs->data == NULL || hs->count == 0){
+        memset(out, 0, n);
+        return 0;
+    }
+
+    size_t hashes[_HS_BATCH];
+    size_t found = 0;
+    for(size_t j = 0; j < n && j < _HS_BATCH; j++){
+        if(vals[j] == NULL) continue;
+        hashes[j] = hs->_hash((size_t)vals[j]);
+        _hashset_prefetch(hs, hashes[j]);
+    }
+    for(size_t j = 0; j < n; j++){
+        void* val = vals[j];
+        if(val == NULL)
+            out[j] = hs->data[hs->cap] != NULL;
+        else
+            out[j] = (uint8_t)_hashset_has_hashed(hs, val, hashes[j % _HS_BATCH]);
+        found += out[j];
+        size_t next = j + _HS_BATCH; // slot j is free now, start on the one _HS_BATCH ahead
+        if(next < n && vals[next] != NULL){
+            hashes[j % _HS_BATCH] = hs->_hash((size_t)vals[next]);
+            _hashset_prefetch(hs, hashes[j % _HS_BATCH]);
+        }
+    }
+    return found;
+}
+
+void hashset_clear(hashset_t* hs){
+    if(hs == NULL) return;
+    if(hs->data)
+        memset(hs->data, 0, (hs->cap + 1) * sizeof(void*));
+#ifdef HASHSET_ROBINHOOD
+    if(hs->_dist)
+        memset(hs->_dist, 0, hs->cap);
+#endif
+    hs->count = 0;
+}
+
+void hashset_destroy(hashset_t* hs){
+    if(hs == NULL) return;
+    if(hs->data)
+        free(hs->data);
+#ifdef HASHSET_ROBINHOOD
+    if(hs->_dist)
+        free(hs->_dist);
+    hs->_dist = 0;
+#endif
+    hs->data = 0;
+    hs->count = 0;
+    hs->cap = 0;
+}
+
+// smallest power of 2 table that holds count values under max load and still has an empty slot after them
+static size_t _hashset_cap_for(hashset_t* hs, size_t count){
+    double load = _hashset_max_load(hs);
+    size_t cap = _HS_MIN_CAP;
+    while(cap * load < count + 1)
+        cap <<= 1;
+    return cap;
+}
+
+void hashset_reserve(hashset_t* hs, size_t count){
+    if(hs == NULL) return;
+    size_t cap = _hashset_cap_for(hs, count);
+    if(cap > hs->cap)
+        _hashset_rehash(hs, cap);
+}
+
+void hashset_shrink_to_fit(hashset_t* hs){
+    if(hs == NULL || hs->data == NULL) return;
+    if(hs->count == 0){
+        hashset_destroy(hs); // keeps hash/equal and max load, set stays usable
+        return;
+    }
+    size_t cap = _hashset_cap_for(hs, hs->count);
+    if(cap < hs->cap)
+        _hashset_rehash(hs, cap);
+}
+
+void hashset_set_max_load(hashset_t* hs, double max_load){
+    if(hs == NULL) return;
+    if(max_load <= 0){
+        hs->_max_load = 0;
+        return;
+    }
+    hs->_max_load = max_load < 0.25 ? 0.25 : max_load > 0.95 ? 0.95 : max_load;
+}
+
+
+hs_iter_t hashset_iter(hashset_t* hs) {
+    if(hs == NULL || hs->data == NULL) return (hs_iter_t){0};
+    hs_iter_t it = {NULL, hs, 0};
+    return it;
+}
+
+int hashset_iter_next(hs_iter_t* it){
+    if(it == NULL || it->_hs == NULL) return 0;
+
+    hashset_t* hs = it->_hs;
+    
+    for(size_t i = it->_index; i < hs->cap + 1; i++){
+        if(hs->data[i] != NULL){
+            if(i == hs->cap)
+                it->value = NULL; //special case for 0/NULL
+            else
+                it->value = hs->data[i];
+            it->_index = i + 1;
+            return 1;
+        }
+    }
+
+    it->_index = hs->cap + 1;
+    return 0;
+}
+
+
+// probes a lookup of value in slot i takes
+static size_t _hashset_probe_len(hashset_t* hs, size_t i){
+#ifdef HASHSET_ROBINHOOD
+    return _hashset_dist(hs, i);
+#else
+    size_t mask = hs->cap - 1;
+    return ((i - (hs->_hash((size_t)hs->data[i]) & mask)) & mask) + 1;
+#endif
+}
+
+size_t hashset_probe_histogram(hashset_t* hs, size_t* hist, size_t nbuckets){
+    if(hs == NULL || hs->data == NULL) return 0;
+    size_t max = 0;
+    for(size_t i = 0; i < hs->cap; i++){
+        if(hs->data[i] == NULL) continue;
+        size_t p = _hashset_probe_len(hs, i);
+        if(p > max)
+            max = p;
+        if(hist && nbuckets)
+            hist[p < nbuckets ? p : nbuckets - 1]++;
+    }
+    return max;
+}
+
+#ifdef HASHSET_STATS
+hs_stats_t hashset_stats(hashset_t* hs){
+    hs_stats_t st = {0};
+    if(hs == NULL) return st;
+    return hs->_stats;
+}
+
+void hashset_stats_reset(hashset_t* hs){
+    if(hs == NULL) return;
+    memset(&hs->_stats, 0, sizeof(hs_stats_t));
+}
+#endif
+
+
+// PS: i have yet to know how hashsets are actually implemented
+#endif
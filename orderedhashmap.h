@@ -0,0 +1,313 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "hashmap.h"
+
+// insertion ordered hashmap, laid out like cpython dicts:
+// entries is a dense array in insertion order, index is a sparse open addressing table of small integers pointing into it.
+// index cells are 1, 2, 4 or 8 bytes wide depending on table size, so the part probing touches stays small
+// and iteration is a linear walk over entries. removal leaves a hole in entries, holes are squeezed out
+// when entries fill up or when they outnumber live entries
+// same key rules as hashmap_t: keys are len bytes, map keeps the pointer
+
+typedef struct ohashmap_t {
+    hm_item_t* entries; // key = NULL marks removed entry
+    size_t nentries; // used entries, holes included
+    size_t entries_cap;
+    void* index; // 0 = empty, 1 = deleted, else entry + 2
+    size_t cap; // index cells, power of 2
+    uint8_t width; // bytes per index cell
+    size_t count;
+
+    size_t (*_hash) (const void*, size_t);
+    int (*_equal) (const void*, const void*, size_t);
+} ohashmap_t;
+
+typedef struct ohm_iter_t {
+    const char* key;
+    size_t len;
+    void* value;
+    ohashmap_t* _hm;
+    size_t _index;
+} ohm_iter_t;
+
+// hash/equal as for hashmap_init, NULL = hashmap_hash / bytewise
+void ohashmap_init(ohashmap_t* hm, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t));
+
+// same return values as hashmap ones, new keys go to the end of the order, changing a value keeps the position
+int ohashmap_set_n_(ohashmap_t* hm, const void* key, size_t len, void* value);
+int ohashmap_tryadd_n_(ohashmap_t* hm, const void* key, size_t len, void* value);
+int ohashmap_trychange_n_(ohashmap_t* hm, const void* key, size_t len, void* value);
+void* ohashmap_get_n(ohashmap_t* hm, const void* key, size_t len);
+void* ohashmap_remove_n(ohashmap_t* hm, const void* key, size_t len);
+
+int ohashmap_set_(ohashmap_t* hm, const char* key, void* value);
+int ohashmap_tryadd_(ohashmap_t* hm, const char* key, void* value);
+int ohashmap_trychange_(ohashmap_t* hm, const char* key, void* value);
+void* ohashmap_get(ohashmap_t* hm, const char* key);
+void* ohashmap_remove(ohashmap_t* hm, const char* key);
+
+// squeezes holes out of entries and rebuilds index
+void ohashmap_compact(ohashmap_t* hm);
+void ohashmap_clear(ohashmap_t* hm);
+void ohashmap_destroy(ohashmap_t* hm);
+
+// walks entries in insertion order, removing while iterating is not supported
+ohm_iter_t ohashmap_iter(ohashmap_t* hm);
+int ohashmap_iter_next(ohm_iter_t* it);
+
+#define ohashmap_set(hm, key, value)       ohashmap_set_(hm, key, (void*)value)
+#define ohashmap_tryadd(hm, key, value)    ohashmap_tryadd_(hm, key, (void*)value)
+#define ohashmap_trychange(hm, key, value) ohashmap_trychange_(hm, key, (void*)value)
+#define ohashmap_set_n(hm, key, len, value)       ohashmap_set_n_(hm, key, len, (void*)value)
+#define ohashmap_tryadd_n(hm, key, len, value)    ohashmap_tryadd_n_(hm, key, len, (void*)value)
+#define ohashmap_trychange_n(hm, key, len, value) ohashmap_trychange_n_(hm, key, len, (void*)value)
+
+
+#ifdef ORDEREDHASHMAP_IMPLEMENTATION
+
+#include <string.h>
+
+#define _OHM_INIT_CAP 8
+#define _OHM_EMPTY 0
+#define _OHM_DELETED 1
+#define _OHM_NOT_FOUND SIZE_MAX
+
+static int _ohm_mem_equal(const void* a, const void* b, size_t len){
+    return memcmp(a, b, len) == 0;
+}
+
+void ohashmap_init(ohashmap_t* hm, size_t (*hash_func) (const void*, size_t), int (*equal_func) (const void*, const void*, size_t)){
+    hm->entries = 0;
+    hm->nentries = 0;
+    hm->entries_cap = 0;
+    hm->index = 0;
+    hm->cap = 0;
+    hm->width = 0;
+    hm->count = 0;
+    hm->_hash = hash_func ? hash_func : hashmap_hash;
+    hm->_equal = equal_func ? equal_func : _ohm_mem_equal;
+}
+
+static inline size_t _ohm_get(const ohashmap_t* hm, size_t i){
+    switch(hm->width){
+    case 1: return ((const uint8_t*)hm->index)[i];
+    case 2: return ((const uint16_t*)hm->index)[i];
+    case 4: return ((const uint32_t*)hm->index)[i];
+    default: return (size_t)((const uint64_t*)hm->index)[i];
+    }
+}
+
+static inline void _ohm_put(ohashmap_t* hm, size_t i, size_t v){
+    switch(hm->width){
+    case 1: ((uint8_t*)hm->index)[i] = (uint8_t)v; break;
+    case 2: ((uint16_t*)hm->index)[i] = (uint16_t)v; break;
+    case 4: ((uint32_t*)hm->index)[i] = (uint32_t)v; break;
+    default: ((uint64_t*)hm->index)[i] = (uint64_t)v; break;
+    }
+}
+
+// entries fill 2/3 of index at most, cell has to hold entries_cap + 1
+static inline uint8_t _ohm_width_for(size_t cap){
+    size_t top = cap * 2 / 3 + 2;
+    if(top <= UINT8_MAX) return 1;
+    if(top <= UINT16_MAX) return 2;
+    if(top <= UINT32_MAX) return 4;
+    return 8;
+}
+
+// linear probing, returns index cell of key
+static size_t _ohm_find(const ohashmap_t* hm, const void* key, size_t len, size_t hash){
+    size_t mask = hm->cap - 1;
+    for(size_t i = hash & mask; ; i = (i + 1) & mask){
+        size_t v = _ohm_get(hm, i);
+        if(v == _OHM_EMPTY)
+            return _OHM_NOT_FOUND;
+        if(v == _OHM_DELETED)
+            continue;
+        const hm_item_t* e = hm->entries + (v - 2);
+        if(e->hash == hash && e->len == len && hm->_equal(e->key, key, len))
+            return i;
+    }
+}
+
+// first empty cell on hash probe sequence, index has no deleted cells right after a rebuild
+static size_t _ohm_find_free(const ohashmap_t* hm, size_t hash){
+    size_t mask = hm->cap - 1;
+    size_t i = hash & mask;
+    while(_ohm_get(hm, i) > _OHM_DELETED)
+        i = (i + 1) & mask;
+    return i;
+}
+
+// new index of cap cells over entries with holes squeezed out
+static void _ohm_rebuild(ohashmap_t* hm, size_t cap){
+    size_t n = 0;
+    for(size_t i = 0; i < hm->nentries; i++)
+        if(hm->entries[i].key != NULL)
+            hm->entries[n++] = hm->entries[i];
+    hm->nentries = n;
+
+    if(cap != hm->cap){
+        hm->entries_cap = cap * 2 / 3;
+        hm->entries = (hm_item_t*)realloc(hm->entries, hm->entries_cap * sizeof(hm_item_t));
+        free(hm->index);
+        hm->cap = cap;
+        hm->width = _ohm_width_for(cap);
+        hm->index = malloc(cap * hm->width);
+    }
+    memset(hm->index, 0, hm->cap * hm->width);
+    for(size_t i = 0; i < n; i++)
+        _ohm_put(hm, _ohm_find_free(hm, hm->entries[i].hash), i + 2);
+}
+
+// room for one more entry. compacts in place when holes free enough of entries, grows otherwise
+static void _ohm_maybe_expand(ohashmap_t* hm){
+    if(hm->nentries < hm->entries_cap) return; // works for hm = {0}, as if wont return if cap is 0
+    if(hm->cap == 0)
+        _ohm_rebuild(hm, _OHM_INIT_CAP);
+    else if(hm->count < hm->entries_cap / 2)
+        _ohm_rebuild(hm, hm->cap);
+    else
+        _ohm_rebuild(hm, hm->cap << 1);
+}
+
+static void _ohm_append(ohashmap_t* hm, const void* key, size_t len, void* value, size_t hash){
+    size_t e = hm->nentries++;
+    hm->entries[e].key = (const char*)key;
+    hm->entries[e].len = len;
+    hm->entries[e].value = value;
+    hm->entries[e].hash = hash;
+    _ohm_put(hm, _ohm_find_free(hm, hash), e + 2);
+    hm->count++;
+}
+
+int ohashmap_set_n_(ohashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || key == NULL) return 0;
+    _ohm_maybe_expand(hm);
+
+    size_t hash = hm->_hash(key, len);
+    size_t i = _ohm_find(hm, key, len, hash);
+    if(i != _OHM_NOT_FOUND){
+        hm->entries[_ohm_get(hm, i) - 2].value = value;
+        return 0;
+    }
+    _ohm_append(hm, key, len, value, hash);
+    return 1;
+}
+
+int ohashmap_tryadd_n_(ohashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || key == NULL) return 0;
+    _ohm_maybe_expand(hm);
+
+    size_t hash = hm->_hash(key, len);
+    if(_ohm_find(hm, key, len, hash) != _OHM_NOT_FOUND)
+        return 0;
+    _ohm_append(hm, key, len, value, hash);
+    return 1;
+}
+
+int ohashmap_trychange_n_(ohashmap_t* hm, const void* key, size_t len, void* value){
+    if(hm == NULL || hm->index == NULL || key == NULL) return 0;
+
+    size_t i = _ohm_find(hm, key, len, hm->_hash(key, len));
+    if(i == _OHM_NOT_FOUND)
+        return 0;
+    hm->entries[_ohm_get(hm, i) - 2].value = value;
+    return 1;
+}
+
+void* ohashmap_get_n(ohashmap_t* hm, const void* key, size_t len){
+    if(hm == NULL || hm->index == NULL || key == NULL) return 0;
+
+    size_t i = _ohm_find(hm, key, len, hm->_hash(key, len));
+    if(i == _OHM_NOT_FOUND)
+        return 0;
+    return hm->entries[_ohm_get(hm, i) - 2].value;
+}
+
+void* ohashmap_remove_n(ohashmap_t* hm, const void* key, size_t len){
+    if(hm == NULL || hm->index == NULL || key == NULL) return 0;
+
+    size_t i = _ohm_find(hm, key, len, hm->_hash(key, len));
+    if(i == _OHM_NOT_FOUND)
+        return 0;
+    hm_item_t* e = hm->entries + (_ohm_get(hm, i) - 2);
+    void* value = e->value;
+    e->key = NULL;
+    e->value = NULL;
+    _ohm_put(hm, i, _OHM_DELETED);
+    hm->count--;
+    if(hm->nentries - hm->count > hm->count && hm->nentries >= _OHM_INIT_CAP) // keeps iteration within 2x live entries
+        _ohm_rebuild(hm, hm->cap);
+    return value;
+}
+
+int ohashmap_set_(ohashmap_t* hm, const char* key, void* value){
+    return key ? ohashmap_set_n_(hm, key, strlen(key), value) : 0;
+}
+int ohashmap_tryadd_(ohashmap_t* hm, const char* key, void* value){
+    return key ? ohashmap_tryadd_n_(hm, key, strlen(key), value) : 0;
+}
+int ohashmap_trychange_(ohashmap_t* hm, const char* key, void* value){
+    return key ? ohashmap_trychange_n_(hm, key, strlen(key), value) : 0;
+}
+void* ohashmap_get(ohashmap_t* hm, const char* key){
+    return key ? ohashmap_get_n(hm, key, strlen(key)) : 0;
+}
+void* ohashmap_remove(ohashmap_t* hm, const char* key){
+    return key ? ohashmap_remove_n(hm, key, strlen(key)) : 0;
+}
+
+void ohashmap_compact(ohashmap_t* hm){
+    if(hm == NULL || hm->index == NULL) return;
+    _ohm_rebuild(hm, hm->cap);
+}
+
+void ohashmap_clear(ohashmap_t* hm){
+    if(hm == NULL) return;
+    if(hm->index)
+        memset(hm->index, 0, hm->cap * hm->width);
+    hm->nentries = 0;
+    hm->count = 0;
+}
+
+void ohashmap_destroy(ohashmap_t* hm){
+    if(hm == NULL) return;
+    free(hm->entries);
+    free(hm->index);
+    hm->entries = 0;
+    hm->index = 0;
+    hm->nentries = 0;
+    hm->entries_cap = 0;
+    hm->cap = 0;
+    hm->width = 0;
+    hm->count = 0;
+}
+
+
+ohm_iter_t ohashmap_iter(ohashmap_t* hm){
+    if(hm == NULL || hm->entries == NULL) return (ohm_iter_t){0};
+    ohm_iter_t it = {NULL, 0, NULL, hm, 0};
+    return it;
+}
+
+int ohashmap_iter_next(ohm_iter_t* it){
+    if(it == NULL || it->_hm == NULL) return 0;
+
+    ohashmap_t* hm = it->_hm;
+    for(size_t i = it->_index; i < hm->nentries; i++){
+        if(hm->entries[i].key != NULL){
+            it->key = hm->entries[i].key;
+            it->len = hm->entries[i].len;
+            it->value = hm->entries[i].value;
+            it->_index = i + 1;
+            return 1;
+        }
+    }
+    it->_index = hm->nentries;
+    return 0;
+}
+
+#endif
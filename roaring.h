@@ -0,0 +1,862 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "bitset.h"
+
+// compressed set of uint32_t, split by high 16 bits into containers holding the low 16 bits:
+//  array  - sorted uint16_t values, used while cardinality <= 4096
+//  bitmap - 65536 bit bitset_t, used above that
+//  run    - (start, length - 1) pairs, only made by roaring_run_optimize
+// serialized form follows the RoaringFormatSpec, so it can be read by other roaring implementations
+// only uses the public bitset api, BITSET_IMPLEMENTATION has to be defined in one file too (e.g. next to ROARING_IMPLEMENTATION)
+
+#define ROARING_ARRAY  0
+#define ROARING_BITMAP 1
+#define ROARING_RUN    2
+
+typedef struct roaring_container_t {
+    uint8_t type;
+    uint32_t card;
+    uint16_t* values; // array values or run pairs
+    uint32_t n; // array values or runs
+    uint32_t cap; // in uint16_ts
+    bitset_t bits;
+} roaring_container_t;
+
+typedef struct roaring_t {
+    uint16_t* keys; // sorted
+    roaring_container_t* containers;
+    size_t count;
+    size_t cap;
+} roaring_t;
+
+typedef struct roaring_iter_t {
+    uint32_t value;
+    roaring_t* _r;
+    size_t _ci; // container
+    size_t _pos; // position inside container, for runs index of run
+    uint32_t _off; // offset inside run
+} roaring_iter_t;
+
+void roaring_init(roaring_t* r); // use if malloced, else roaring_t r = {0};
+void roaring_clear(roaring_t* r);
+void roaring_destroy(roaring_t* r);
+
+// added = 1, already exists = 0
+int roaring_add(roaring_t* r, uint32_t x);
+// removed = 1, not exists = 0
+int roaring_remove(roaring_t* r, uint32_t x);
+// exists = 1, not exists = 0
+int roaring_contains(const roaring_t* r, uint32_t x);
+uint64_t roaring_cardinality(const roaring_t* r);
+
+// dst may be a or b
+void roaring_and(roaring_t* dst, const roaring_t* a, const roaring_t* b);
+void roaring_or(roaring_t* dst, const roaring_t* a, const roaring_t* b);
+// a & ~b
+void roaring_andnot(roaring_t* dst, const roaring_t* a, const roaring_t* b);
+
+// converts containers to runs where that is smaller
+void roaring_run_optimize(roaring_t* r);
+
+roaring_iter_t roaring_iter(roaring_t* r);
+int roaring_iter_next(roaring_iter_t* it);
+
+size_t roaring_serialized_size(const roaring_t* r);
+// out must hold roaring_serialized_size bytes, returns bytes written
+size_t roaring_serialize(const roaring_t* r, uint8_t* out);
+// ok = 1, malformed = 0, r is initialized either way
+int roaring_deserialize(roaring_t* r, const uint8_t* buf, size_t len);
+
+
+#ifdef ROARING_IMPLEMENTATION
+
+#include <string.h>
+
+#define _ROARING_ARRAY_MAX 4096
+#define _ROARING_BITMAP_WORDS 1024
+#define _ROARING_COOKIE_NO_RUN 12346
+#define _ROARING_COOKIE 12347
+#define _ROARING_NO_OFFSET_THRESHOLD 4
+
+#define _rc_bit(c, x) (((c)->bits.data[(x) >> 6] >> ((x) & 63)) & 1)
+
+static void _rc_reserve(roaring_container_t* c, uint32_t cap){
+    if(c->cap >= cap) return;
+    uint32_t new_cap = c->cap ? c->cap : 4;
+    while(new_cap < cap)
+        new_cap <<= 1;
+    c->values = (uint16_t*)realloc(c->values, new_cap * sizeof(uint16_t));
+    c->cap = new_cap;
+}
+
+static void _rc_init(roaring_container_t* c, uint8_t type){
+    memset(c, 0, sizeof(*c));
+    c->type = type;
+    if(type == ROARING_BITMAP){
+        bitset_resize(&c->bits, _ROARING_BITMAP_WORDS << 6); // new bits are 0
+    }
+}
+
+static void _rc_free(roaring_container_t* c){
+    if(c->values)
+        free(c->values);
+    bitset_destroy(&c->bits);
+    memset(c, 0, sizeof(*c));
+}
+
+static void _rc_copy(roaring_container_t* dst, const roaring_container_t* src){
+    _rc_init(dst, src->type);
+    dst->card = src->card;
+    dst->n = src->n;
+    if(src->type == ROARING_BITMAP){
+        memcpy(dst->bits.data, src->bits.data, _ROARING_BITMAP_WORDS * sizeof(uint64_t));
+    }else{
+        uint32_t len = src->type == ROARING_RUN ? src->n * 2 : src->n;
+        _rc_reserve(dst, len);
+        if(len)
+            memcpy(dst->values, src->values, len * sizeof(uint16_t));
+    }
+}
+
+static void _rc_array_to_bitmap(roaring_container_t* c){
+    roaring_container_t b;
+    _rc_init(&b, ROARING_BITMAP);
+    for(uint32_t i = 0; i < c->n; i++)
+        b.bits.data[c->values[i] >> 6] |= (uint64_t)1 << (c->values[i] & 63);
+    b.card = c->n;
+    _rc_free(c);
+    *c = b;
+}
+
+static void _rc_bitmap_to_array(roaring_container_t* c){
+    roaring_container_t a;
+    _rc_init(&a, ROARING_ARRAY);
+    _rc_reserve(&a, c->card);
+    bitset_foreach_set(&c->bits, i){
+        a.values[a.n++] = (uint16_t)i;
+    }
+    a.card = a.n;
+    _rc_free(c);
+    *c = a;
+}
+
+static void _rc_bitmap_set_range(roaring_container_t* c, uint32_t start, uint32_t end){ // inclusive end
+    uint32_t ws = start >> 6, we = end >> 6;
+    uint64_t first = ~(uint64_t)0 << (start & 63);
+    uint64_t last = ~(uint64_t)0 >> (63 - (end & 63));
+    if(ws == we){
+        c->bits.data[ws] |= first & last;
+        return;
+    }
+    c->bits.data[ws] |= first;
+    for(uint32_t w = ws + 1; w < we; w++)
+        c->bits.data[w] = ~(uint64_t)0;
+    c->bits.data[we] |= last;
+}
+
+// turns a run container back into array or bitmap, whichever fits the cardinality
+static void _rc_unrun(roaring_container_t* c){
+    roaring_container_t u;
+    if(c->card > _ROARING_ARRAY_MAX){
+        _rc_init(&u, ROARING_BITMAP);
+        for(uint32_t i = 0; i < c->n; i++)
+            _rc_bitmap_set_range(&u, c->values[2 * i], c->values[2 * i] + c->values[2 * i + 1]);
+    }else{
+        _rc_init(&u, ROARING_ARRAY);
+        _rc_reserve(&u, c->card);
+        for(uint32_t i = 0; i < c->n; i++){
+            uint32_t start = c->values[2 * i];
+            uint32_t end = start + c->values[2 * i + 1]; // inclusive
+            for(uint32_t x = start; x <= end; x++)
+                u.values[u.n++] = (uint16_t)x;
+        }
+    }
+    u.card = c->card;
+    _rc_free(c);
+    *c = u;
+}
+
+// keeps array/bitmap choice in line with cardinality after bulk ops
+static void _rc_normalize(roaring_container_t* c){
+    if(c->type == ROARING_BITMAP && c->card <= _ROARING_ARRAY_MAX)
+        _rc_bitmap_to_array(c);
+    else if(c->type == ROARING_ARRAY && c->card > _ROARING_ARRAY_MAX)
+        _rc_array_to_bitmap(c);
+}
+
+// first index with values[i] >= x
+static uint32_t _rc_lower_bound(const uint16_t* values, uint32_t n, uint16_t x){
+    uint32_t lo = 0, hi = n;
+    while(lo < hi){
+        uint32_t mid = (lo + hi) >> 1;
+        if(values[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int _rc_contains(const roaring_container_t* c, uint16_t x){
+    if(c->type == ROARING_BITMAP)
+        return _rc_bit(c, x);
+    if(c->type == ROARING_ARRAY){
+        uint32_t i = _rc_lower_bound(c->values, c->n, x);
+        return i < c->n && c->values[i] == x;
+    }
+    uint32_t lo = 0, hi = c->n; // last run with start <= x
+    while(lo < hi){
+        uint32_t mid = (lo + hi) >> 1;
+        if(c->values[2 * mid] <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo == 0) return 0;
+    return x - c->values[2 * (lo - 1)] <= c->values[2 * (lo - 1) + 1];
+}
+
+static int _rc_add(roaring_container_t* c, uint16_t x){
+    if(c->type == ROARING_RUN){
+        if(_rc_contains(c, x)) return 0;
+        _rc_unrun(c);
+    }
+    if(c->type == ROARING_ARRAY){
+        uint32_t i = _rc_lower_bound(c->values, c->n, x);
+        if(i < c->n && c->values[i] == x) return 0;
+        if(c->n >= _ROARING_ARRAY_MAX){
+            _rc_array_to_bitmap(c);
+            return _rc_add(c, x);
+        }
+        _rc_reserve(c, c->n + 1);
+        memmove(c->values + i + 1, c->values + i, (c->n - i) * sizeof(uint16_t));
+        c->values[i] = x;
+        c->n++;
+        c->card++;
+        return 1;
+    }
+    if(_rc_bit(c, x)) return 0;
+    c->bits.data[x >> 6] |= (uint64_t)1 << (x & 63);
+    c->card++;
+    return 1;
+}
+
+static int _rc_remove(roaring_container_t* c, uint16_t x){
+    if(c->type == ROARING_RUN){
+        if(!_rc_contains(c, x)) return 0;
+        _rc_unrun(c);
+    }
+    if(c->type == ROARING_ARRAY){
+        uint32_t i = _rc_lower_bound(c->values, c->n, x);
+        if(i >= c->n || c->values[i] != x) return 0;
+        memmove(c->values + i, c->values + i + 1, (c->n - i - 1) * sizeof(uint16_t));
+        c->n--;
+        c->card--;
+        return 1;
+    }
+    if(!_rc_bit(c, x)) return 0;
+    c->bits.data[x >> 6] &= ~((uint64_t)1 << (x & 63));
+    c->card--;
+    _rc_normalize(c);
+    return 1;
+}
+
+static uint32_t _rc_bitmap_runs(const roaring_container_t* c){
+    uint32_t runs = 0;
+    uint64_t prev = 0;
+    for(size_t i = 0; i < _ROARING_BITMAP_WORDS; i++){
+        uint64_t w = c->bits.data[i];
+        runs += __builtin_popcountll(w & ~((w << 1) | (prev >> 63))); // run starts
+        prev = w;
+    }
+    return runs;
+}
+
+static uint32_t _rc_array_runs(const roaring_container_t* c){
+    uint32_t runs = 0;
+    for(uint32_t i = 0; i < c->n; i++){
+        if(i == 0 || c->values[i] != c->values[i - 1] + 1)
+            runs++;
+    }
+    return runs;
+}
+
+static void _rc_to_run(roaring_container_t* c, uint32_t runs){
+    roaring_container_t r;
+    _rc_init(&r, ROARING_RUN);
+    _rc_reserve(&r, runs * 2);
+    if(c->type == ROARING_ARRAY){
+        for(uint32_t i = 0; i < c->n; i++){
+            if(r.n > 0 && c->values[i] == r.values[2 * (r.n - 1)] + r.values[2 * (r.n - 1) + 1] + 1){
+                r.values[2 * (r.n - 1) + 1]++;
+            }else{
+                r.values[2 * r.n] = c->values[i];
+                r.values[2 * r.n + 1] = 0;
+                r.n++;
+            }
+        }
+    }else{
+        size_t x = bitset_find_first(&c->bits);
+        while(x < c->bits.count){
+            size_t end = bitset_find_next_zero(&c->bits, x);
+            r.values[2 * r.n] = (uint16_t)x;
+            r.values[2 * r.n + 1] = (uint16_t)(end - x - 1);
+            r.n++;
+            x = bitset_find_next(&c->bits, end);
+        }
+    }
+    r.card = c->card;
+    _rc_free(c);
+    *c = r;
+}
+
+// result containers of the binary ops, empty result = card 0
+
+static void _rc_and(roaring_container_t* out, const roaring_container_t* a, const roaring_container_t* b){
+    if(a->type == ROARING_BITMAP && b->type == ROARING_BITMAP){
+        _rc_init(out, ROARING_BITMAP);
+        bitset_and(&out->bits, &a->bits, &b->bits);
+        out->card = (uint32_t)bitset_count(&out->bits);
+        _rc_normalize(out);
+        return;
+    }
+    _rc_init(out, ROARING_ARRAY);
+    if(a->type == ROARING_BITMAP){
+        const roaring_container_t* t = a; a = b; b = t;
+    }
+    _rc_reserve(out, a->n);
+    if(b->type == ROARING_BITMAP){
+        for(uint32_t i = 0; i < a->n; i++){
+            if(_rc_bit(b, a->values[i]))
+                out->values[out->n++] = a->values[i];
+        }
+    }else{
+        uint32_t i = 0, j = 0;
+        while(i < a->n && j < b->n){
+            if(a->values[i] < b->values[j]) i++;
+            else if(a->values[i] > b->values[j]) j++;
+            else{
+                out->values[out->n++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+    }
+    out->card = out->n;
+}
+
+static void _rc_or(roaring_container_t* out, const roaring_container_t* a, const roaring_container_t* b){
+    if(a->type == ROARING_BITMAP && b->type == ROARING_BITMAP){
+        _rc_init(out, ROARING_BITMAP);
+        bitset_or(&out->bits, &a->bits, &b->bits);
+        out->card = (uint32_t)bitset_count(&out->bits);
+        return;
+    }
+    if(a->type == ROARING_BITMAP || b->type == ROARING_BITMAP){
+        if(a->type != ROARING_BITMAP){
+            const roaring_container_t* t = a; a = b; b = t;
+        }
+        _rc_copy(out, a);
+        for(uint32_t i = 0; i < b->n; i++){
+            uint16_t x = b->values[i];
+            out->card += !_rc_bit(out, x);
+            out->bits.data[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+        return;
+    }
+    _rc_init(out, ROARING_ARRAY);
+    _rc_reserve(out, a->n + b->n);
+    uint32_t i = 0, j = 0;
+    while(i < a->n || j < b->n){
+        if(j >= b->n || (i < a->n && a->values[i] < b->values[j]))
+            out->values[out->n++] = a->values[i++];
+        else if(i >= a->n || b->values[j] < a->values[i])
+            out->values[out->n++] = b->values[j++];
+        else{
+            out->values[out->n++] = a->values[i];
+            i++;
+            j++;
+        }
+    }
+    out->card = out->n;
+    _rc_normalize(out);
+}
+
+static void _rc_andnot(roaring_container_t* out, const roaring_container_t* a, const roaring_container_t* b){
+    if(a->type == ROARING_BITMAP){
+        if(b->type == ROARING_BITMAP){
+            _rc_init(out, ROARING_BITMAP);
+            bitset_andnot(&out->bits, &a->bits, &b->bits);
+            out->card = (uint32_t)bitset_count(&out->bits);
+        }else{
+            _rc_copy(out, a);
+            for(uint32_t i = 0; i < b->n; i++){
+                uint16_t x = b->values[i];
+                out->card -= _rc_bit(out, x);
+                out->bits.data[x >> 6] &= ~((uint64_t)1 << (x & 63));
+            }
+        }
+        _rc_normalize(out);
+        return;
+    }
+    _rc_init(out, ROARING_ARRAY);
+    _rc_reserve(out, a->n);
+    if(b->type == ROARING_BITMAP){
+        for(uint32_t i = 0; i < a->n; i++){
+            if(!_rc_bit(b, a->values[i]))
+                out->values[out->n++] = a->values[i];
+        }
+    }else{
+        uint32_t i = 0, j = 0;
+        while(i < a->n){
+            if(j >= b->n || a->values[i] < b->values[j])
+                out->values[out->n++] = a->values[i++];
+            else if(a->values[i] > b->values[j])
+                j++;
+            else{
+                i++;
+                j++;
+            }
+        }
+    }
+    out->card = out->n;
+}
+
+typedef void (*_rc_binop_t)(roaring_container_t*, const roaring_container_t*, const roaring_container_t*);
+
+// runs are expanded into a temporary before the op
+static void _rc_binop(roaring_container_t* out, const roaring_container_t* a, const roaring_container_t* b, _rc_binop_t op){
+    roaring_container_t ta, tb;
+    if(a->type == ROARING_RUN){
+        _rc_copy(&ta, a);
+        _rc_unrun(&ta);
+        a = &ta;
+    }
+    if(b->type == ROARING_RUN){
+        _rc_copy(&tb, b);
+        _rc_unrun(&tb);
+        b = &tb;
+    }
+    op(out, a, b);
+    if(a == &ta) _rc_free(&ta);
+    if(b == &tb) _rc_free(&tb);
+}
+
+
+void roaring_init(roaring_t* r){
+    r->keys = NULL;
+    r->containers = NULL;
+    r->count = 0;
+    r->cap = 0;
+}
+
+void roaring_clear(roaring_t* r){
+    if(r == NULL) return;
+    for(size_t i = 0; i < r->count; i++)
+        _rc_free(&r->containers[i]);
+    r->count = 0;
+}
+
+void roaring_destroy(roaring_t* r){
+    if(r == NULL) return;
+    roaring_clear(r);
+    if(r->keys)
+        free(r->keys);
+    if(r->containers)
+        free(r->containers);
+    roaring_init(r);
+}
+
+// index of container with key, or where it would be inserted
+static size_t _roaring_find(const roaring_t* r, uint16_t key){
+    size_t lo = 0, hi = r->count;
+    while(lo < hi){
+        size_t mid = (lo + hi) >> 1;
+        if(r->keys[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void _roaring_reserve(roaring_t* r, size_t cap){
+    if(r->cap >= cap) return;
+    size_t new_cap = r->cap ? r->cap * 2 : 4;
+    if(new_cap < cap)
+        new_cap = cap;
+    r->keys = (uint16_t*)realloc(r->keys, new_cap * sizeof(uint16_t));
+    r->containers = (roaring_container_t*)realloc(r->containers, new_cap * sizeof(roaring_container_t));
+    r->cap = new_cap;
+}
+
+static void _roaring_insert_at(roaring_t* r, size_t i, uint16_t key, const roaring_container_t* c){
+    _roaring_reserve(r, r->count + 1);
+    memmove(r->keys + i + 1, r->keys + i, (r->count - i) * sizeof(uint16_t));
+    memmove(r->containers + i + 1, r->containers + i, (r->count - i) * sizeof(roaring_container_t));
+    r->keys[i] = key;
+    r->containers[i] = *c;
+    r->count++;
+}
+
+static void _roaring_erase_at(roaring_t* r, size_t i){
+    _rc_free(&r->containers[i]);
+    memmove(r->keys + i, r->keys + i + 1, (r->count - i - 1) * sizeof(uint16_t));
+    memmove(r->containers + i, r->containers + i + 1, (r->count - i - 1) * sizeof(roaring_container_t));
+    r->count--;
+}
+
+// takes ownership of c, drops it if empty
+static void _roaring_append(roaring_t* r, uint16_t key, roaring_container_t* c){
+    if(c->card == 0){
+        _rc_free(c);
+        return;
+    }
+    _roaring_insert_at(r, r->count, key, c);
+}
+
+int roaring_add(roaring_t* r, uint32_t x){
+    if(r == NULL) return 0;
+    uint16_t key = (uint16_t)(x >> 16);
+    size_t i = _roaring_find(r, key);
+    if(i == r->count || r->keys[i] != key){
+        roaring_container_t c;
+        _rc_init(&c, ROARING_ARRAY);
+        _roaring_insert_at(r, i, key, &c);
+    }
+    return _rc_add(&r->containers[i], (uint16_t)x);
+}
+
+int roaring_remove(roaring_t* r, uint32_t x){
+    if(r == NULL) return 0;
+    uint16_t key = (uint16_t)(x >> 16);
+    size_t i = _roaring_find(r, key);
+    if(i == r->count || r->keys[i] != key) return 0;
+    if(!_rc_remove(&r->containers[i], (uint16_t)x)) return 0;
+    if(r->containers[i].card == 0)
+        _roaring_erase_at(r, i);
+    return 1;
+}
+
+int roaring_contains(const roaring_t* r, uint32_t x){
+    if(r == NULL) return 0;
+    uint16_t key = (uint16_t)(x >> 16);
+    size_t i = _roaring_find(r, key);
+    if(i == r->count || r->keys[i] != key) return 0;
+    return _rc_contains(&r->containers[i], (uint16_t)x);
+}
+
+uint64_t roaring_cardinality(const roaring_t* r){
+    if(r == NULL) return 0;
+    uint64_t card = 0;
+    for(size_t i = 0; i < r->count; i++)
+        card += r->containers[i].card;
+    return card;
+}
+
+// results are built in res and moved into dst at the end, so dst can alias a or b
+
+void roaring_and(roaring_t* dst, const roaring_t* a, const roaring_t* b){
+    if(dst == NULL || a == NULL || b == NULL) return;
+    roaring_t res = {0};
+    roaring_container_t c;
+    size_t i = 0, j = 0;
+    while(i < a->count && j < b->count){
+        if(a->keys[i] < b->keys[j]) i++;
+        else if(a->keys[i] > b->keys[j]) j++;
+        else{
+            _rc_binop(&c, &a->containers[i], &b->containers[j], _rc_and);
+            _roaring_append(&res, a->keys[i], &c);
+            i++;
+            j++;
+        }
+    }
+    roaring_destroy(dst);
+    *dst = res;
+}
+
+void roaring_or(roaring_t* dst, const roaring_t* a, const roaring_t* b){
+    if(dst == NULL || a == NULL || b == NULL) return;
+    roaring_t res = {0};
+    roaring_container_t c;
+    size_t i = 0, j = 0;
+    while(i < a->count || j < b->count){
+        if(j >= b->count || (i < a->count && a->keys[i] < b->keys[j])){
+            _rc_copy(&c, &a->containers[i]);
+            _roaring_append(&res, a->keys[i++], &c);
+        }else if(i >= a->count || b->keys[j] < a->keys[i]){
+            _rc_copy(&c, &b->containers[j]);
+            _roaring_append(&res, b->keys[j++], &c);
+        }else{
+            _rc_binop(&c, &a->containers[i], &b->containers[j], _rc_or);
+            _roaring_append(&res, a->keys[i], &c);
+            i++;
+            j++;
+        }
+    }
+    roaring_destroy(dst);
+    *dst = res;
+}
+
+void roaring_andnot(roaring_t* dst, const roaring_t* a, const roaring_t* b){
+    if(dst == NULL || a == NULL || b == NULL) return;
+    roaring_t res = {0};
+    roaring_container_t c;
+    size_t i = 0, j = 0;
+    while(i < a->count){
+        if(j >= b->count || a->keys[i] < b->keys[j]){
+            _rc_copy(&c, &a->containers[i]);
+            _roaring_append(&res, a->keys[i++], &c);
+        }else if(a->keys[i] > b->keys[j])
+            j++;
+        else{
+            _rc_binop(&c, &a->containers[i], &b->containers[j], _rc_andnot);
+            _roaring_append(&res, a->keys[i], &c);
+            i++;
+            j++;
+        }
+    }
+    roaring_destroy(dst);
+    *dst = res;
+}
+
+void roaring_run_optimize(roaring_t* r){
+    if(r == NULL) return;
+    for(size_t i = 0; i < r->count; i++){
+        roaring_container_t* c = &r->containers[i];
+        if(c->type == ROARING_RUN) continue;
+        uint32_t runs = c->type == ROARING_ARRAY ? _rc_array_runs(c) : _rc_bitmap_runs(c);
+        size_t run_size = 2 + 4 * (size_t)runs;
+        size_t size = c->type == ROARING_ARRAY ? 2 * (size_t)c->n : _ROARING_BITMAP_WORDS * sizeof(uint64_t);
+        if(run_size < size)
+            _rc_to_run(c, runs);
+    }
+}
+
+
+roaring_iter_t roaring_iter(roaring_t* r){
+    if(r == NULL) return (roaring_iter_t){0};
+    roaring_iter_t it = {0, r, 0, 0, 0};
+    return it;
+}
+
+int roaring_iter_next(roaring_iter_t* it){
+    if(it == NULL || it->_r == NULL) return 0;
+    roaring_t* r = it->_r;
+    while(it->_ci < r->count){
+        roaring_container_t* c = &r->containers[it->_ci];
+        uint32_t high = (uint32_t)r->keys[it->_ci] << 16;
+        if(c->type == ROARING_ARRAY){
+            if(it->_pos < c->n){
+                it->value = high | c->values[it->_pos++];
+                return 1;
+            }
+        }else if(c->type == ROARING_BITMAP){
+            size_t x = bitset_find_next(&c->bits, it->_pos);
+            if(x < c->bits.count){
+                it->value = high | (uint32_t)x;
+                it->_pos = x + 1;
+                return 1;
+            }
+        }else{
+            if(it->_pos < c->n){
+                it->value = high | (uint32_t)(c->values[2 * it->_pos] + it->_off);
+                if(it->_off++ == c->values[2 * it->_pos + 1]){
+                    it->_pos++;
+                    it->_off = 0;
+                }
+                return 1;
+            }
+        }
+        it->_ci++;
+        it->_pos = 0;
+        it->_off = 0;
+    }
+    return 0;
+}
+
+
+static void _roaring_put16(uint8_t* p, uint16_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+static void _roaring_put32(uint8_t* p, uint32_t v){
+    _roaring_put16(p, (uint16_t)v);
+    _roaring_put16(p + 2, (uint16_t)(v >> 16));
+}
+static uint16_t _roaring_get16(const uint8_t* p){
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+static uint32_t _roaring_get32(const uint8_t* p){
+    return _roaring_get16(p) | ((uint32_t)_roaring_get16(p + 2) << 16);
+}
+
+static size_t _rc_serialized_size(const roaring_container_t* c){
+    if(c->type == ROARING_RUN) return 2 + 4 * (size_t)c->n;
+    if(c->type == ROARING_BITMAP) return _ROARING_BITMAP_WORDS * sizeof(uint64_t);
+    return 2 * (size_t)c->n;
+}
+
+static int _roaring_has_runs(const roaring_t* r){
+    for(size_t i = 0; i < r->count; i++){
+        if(r->containers[i].type == ROARING_RUN) return 1;
+    }
+    return 0;
+}
+
+static size_t _roaring_header_size(size_t count, int has_runs){
+    if(has_runs)
+        return 4 + (count + 7) / 8 + 4 * count + (count >= _ROARING_NO_OFFSET_THRESHOLD ? 4 * count : 0);
+    return 8 + 8 * count;
+}
+
+size_t roaring_serialized_size(const roaring_t* r){
+    if(r == NULL) return 0;
+    size_t size = _roaring_header_size(r->count, _roaring_has_runs(r));
+    for(size_t i = 0; i < r->count; i++)
+        size += _rc_serialized_size(&r->containers[i]);
+    return size;
+}
+
+size_t roaring_serialize(const roaring_t* r, uint8_t* out){
+    if(r == NULL || out == NULL) return 0;
+    int has_runs = _roaring_has_runs(r);
+    uint8_t* p = out;
+    if(has_runs){
+        _roaring_put32(p, _ROARING_COOKIE | (uint32_t)((r->count - 1) << 16));
+        p += 4;
+        memset(p, 0, (r->count + 7) / 8);
+        for(size_t i = 0; i < r->count; i++){
+            if(r->containers[i].type == ROARING_RUN)
+                p[i >> 3] |= 1 << (i & 7);
+        }
+        p += (r->count + 7) / 8;
+    }else{
+        _roaring_put32(p, _ROARING_COOKIE_NO_RUN);
+        _roaring_put32(p + 4, (uint32_t)r->count);
+        p += 8;
+    }
+    for(size_t i = 0; i < r->count; i++){
+        _roaring_put16(p, r->keys[i]);
+        _roaring_put16(p + 2, (uint16_t)(r->containers[i].card - 1));
+        p += 4;
+    }
+    size_t offset = _roaring_header_size(r->count, has_runs);
+    if(!has_runs || r->count >= _ROARING_NO_OFFSET_THRESHOLD){
+        for(size_t i = 0; i < r->count; i++){
+            _roaring_put32(p, (uint32_t)offset);
+            offset += _rc_serialized_size(&r->containers[i]);
+            p += 4;
+        }
+    }
+    for(size_t i = 0; i < r->count; i++){
+        const roaring_container_t* c = &r->containers[i];
+        if(c->type == ROARING_RUN){
+            _roaring_put16(p, (uint16_t)c->n);
+            p += 2;
+            for(uint32_t k = 0; k < 2 * c->n; k++, p += 2)
+                _roaring_put16(p, c->values[k]);
+        }else if(c->type == ROARING_BITMAP){
+            for(size_t w = 0; w < _ROARING_BITMAP_WORDS; w++, p += 8){
+                _roaring_put32(p, (uint32_t)c->bits.data[w]);
+                _roaring_put32(p + 4, (uint32_t)(c->bits.data[w] >> 32));
+            }
+        }else{
+            for(uint32_t k = 0; k < c->n; k++, p += 2)
+                _roaring_put16(p, c->values[k]);
+        }
+    }
+    return (size_t)(p - out);
+}
+
+int roaring_deserialize(roaring_t* r, const uint8_t* buf, size_t len){
+    roaring_init(r);
+    if(buf == NULL || len < 4) return 0;
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + len;
+    const uint8_t* run_flags = NULL;
+    size_t count;
+    uint32_t cookie = _roaring_get32(p);
+    if((cookie & 0xffff) == _ROARING_COOKIE){
+        count = (cookie >> 16) + 1;
+        p += 4;
+        if((size_t)(end - p) < (count + 7) / 8) return 0;
+        run_flags = p;
+        p += (count + 7) / 8;
+    }else if(cookie == _ROARING_COOKIE_NO_RUN){
+        if(len < 8) return 0;
+        count = _roaring_get32(p + 4);
+        p += 8;
+    }else
+        return 0;
+    if(count > 1 << 16) return 0;
+    const uint8_t* desc = p;
+    if((size_t)(end - p) < 4 * count) return 0;
+    p += 4 * count;
+    if(!run_flags || count >= _ROARING_NO_OFFSET_THRESHOLD){
+        if((size_t)(end - p) < 4 * count) return 0;
+        p += 4 * count; // offsets are redundant when reading sequentially
+    }
+
+    _roaring_reserve(r, count);
+    for(size_t i = 0; i < count; i++){
+        uint16_t key = _roaring_get16(desc + 4 * i);
+        uint32_t card = (uint32_t)_roaring_get16(desc + 4 * i + 2) + 1;
+        if(i > 0 && key <= r->keys[i - 1]) goto fail;
+        roaring_container_t c;
+        if(run_flags && (run_flags[i >> 3] >> (i & 7)) & 1){
+            if(end - p < 2) goto fail;
+            uint32_t runs = _roaring_get16(p);
+            p += 2;
+            if((size_t)(end - p) < 4 * (size_t)runs) goto fail;
+            _rc_init(&c, ROARING_RUN);
+            _rc_reserve(&c, runs * 2);
+            c.n = runs;
+            card = 0;
+            for(uint32_t k = 0; k < runs; k++, p += 4){
+                c.values[2 * k] = _roaring_get16(p);
+                c.values[2 * k + 1] = _roaring_get16(p + 2);
+                card += (uint32_t)c.values[2 * k + 1] + 1;
+                if((uint32_t)c.values[2 * k] + c.values[2 * k + 1] > 0xffff || (k > 0 && c.values[2 * k] <= (uint32_t)c.values[2 * k - 2] + c.values[2 * k - 1])){
+                    _rc_free(&c);
+                    goto fail;
+                }
+            }
+            if(card == 0){
+                _rc_free(&c);
+                goto fail;
+            }
+        }else if(card > _ROARING_ARRAY_MAX){
+            if((size_t)(end - p) < _ROARING_BITMAP_WORDS * sizeof(uint64_t)) goto fail;
+            _rc_init(&c, ROARING_BITMAP);
+            for(size_t w = 0; w < _ROARING_BITMAP_WORDS; w++, p += 8)
+                c.bits.data[w] = _roaring_get32(p) | ((uint64_t)_roaring_get32(p + 4) << 32);
+            if(bitset_count(&c.bits) != card){
+                _rc_free(&c);
+                goto fail;
+            }
+        }else{
+            if((size_t)(end - p) < 2 * (size_t)card) goto fail;
+            _rc_init(&c, ROARING_ARRAY);
+            _rc_reserve(&c, card);
+            c.n = card;
+            for(uint32_t k = 0; k < card; k++, p += 2){
+                c.values[k] = _roaring_get16(p);
+                if(k > 0 && c.values[k] <= c.values[k - 1]){ // search and merges rely on strictly sorted arrays
+                    _rc_free(&c);
+                    goto fail;
+                }
+            }
+        }
+        c.card = card;
+        _roaring_insert_at(r, r->count, key, &c);
+    }
+    return 1;
+fail:
+    roaring_destroy(r);
+    return 0;
+}
+
+#endif
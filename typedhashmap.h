@@ -0,0 +1,208 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// typed hashmap generator, keys and values sit inline in the slot array and hash/eq get inlined into the probe
+// HASHMAP_DEFINE(name, K, V, hash_fn, eq_fn) makes name_t and name_set/tryadd/trychange/get/remove/iter...
+// hash_fn(K) -> size_t, eq_fn(K, K) -> nonzero when equal, both can be functions or function like macros
+// linear probing, ctrl byte per slot is 0 when empty or 0x80 | 7 bit tag of the hash when full so most misses skip eq_fn,
+// removal shifts the run back instead of leaving tombstones
+/* example:
+HASHMAP_DEFINE(i64map, int64_t, struct thing, thm_hash_int, thm_equal)
+i64map_t m;
+i64map_init(&m);
+i64map_set(&m, 42, thing);
+struct thing* t = i64map_get(&m, 42);
+*/
+
+// for integer/pointer keys
+static inline size_t thm_hash_int(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+#define thm_equal(a, b) ((a) == (b))
+
+#define _THM_INIT_CAP (1 << 4)
+#define _THM_GROW_THRESHOLD 0.8
+// top bits of hash times golden ratio, so every hash bit feeds the tag even for 32 bit size_t or identity like hash_fn
+#define _THM_TAG(hash) ((uint8_t)(0x80 | (((uint64_t)(hash) * 0x9e3779b97f4a7c15ull) >> 57)))
+
+#define HASHMAP_DEFINE(name, K, V, hash_fn, eq_fn) \
+ \
+typedef struct name##_slot_t { \
+    K key; \
+    V value; \
+} name##_slot_t; \
+ \
+typedef struct name##_t { \
+    name##_slot_t* slots; \
+    uint8_t* ctrl; \
+    size_t count; \
+    size_t cap; /* power of 2 */ \
+} name##_t; \
+ \
+typedef struct name##_iter_t { \
+    K* key; \
+    V* value; \
+    name##_t* _m; \
+    size_t _index; \
+} name##_iter_t; \
+ \
+static inline void name##_init(name##_t* m){ \
+    m->slots = NULL; \
+    m->ctrl = NULL; \
+    m->count = 0; \
+    m->cap = 0; \
+} \
+ \
+/* slot of key or cap if not in map */ \
+static inline size_t _##name##_find(const name##_t* m, K key, size_t hash){ \
+    size_t mask = m->cap - 1; \
+    uint8_t tag = _THM_TAG(hash); \
+    for(size_t i = hash & mask; ; i = (i + 1) & mask){ \
+        uint8_t c = m->ctrl[i]; \
+        if(c == 0) \
+            return m->cap; \
+        if(c == tag && eq_fn(m->slots[i].key, key)) \
+            return i; \
+    } \
+} \
+ \
+/* key must not be in map and there must be room */ \
+static inline void _##name##_insert(name##_t* m, K key, V value, size_t hash){ \
+    size_t mask = m->cap - 1; \
+    size_t i = hash & mask; \
+    while(m->ctrl[i]) \
+        i = (i + 1) & mask; \
+    m->ctrl[i] = _THM_TAG(hash); \
+    m->slots[i].key = key; \
+    m->slots[i].value = value; \
+    m->count++; \
+} \
+ \
+static inline void _##name##_rehash(name##_t* m, size_t cap){ \
+    name##_slot_t* old_slots = m->slots; \
+    uint8_t* old_ctrl = m->ctrl; \
+    size_t old_cap = m->cap; \
+    m->slots = (name##_slot_t*)malloc(cap * sizeof(name##_slot_t)); \
+    m->ctrl = (uint8_t*)calloc(cap, 1); \
+    m->cap = cap; \
+    m->count = 0; \
+    for(size_t i = 0; i < old_cap; i++) \
+        if(old_ctrl[i]) \
+            _##name##_insert(m, old_slots[i].key, old_slots[i].value, hash_fn(old_slots[i].key)); \
+    free(old_slots); \
+    free(old_ctrl); \
+} \
+ \
+static inline void _##name##_maybe_expand(name##_t* m){ \
+    if(m->count + 1 < m->cap * _THM_GROW_THRESHOLD) return; /* works for zeroed map, as if wont return if cap is 0 */ \
+    _##name##_rehash(m, m->cap == 0 ? _THM_INIT_CAP : m->cap << 1); \
+} \
+ \
+/* added = 1, changed(existed) = 0 */ \
+static inline int name##_set(name##_t* m, K key, V value){ \
+    if(m == NULL) return 0; \
+    _##name##_maybe_expand(m); \
+    size_t hash = hash_fn(key); \
+    size_t i = _##name##_find(m, key, hash); \
+    if(i != m->cap){ \
+        m->slots[i].value = value; \
+        return 0; \
+    } \
+    _##name##_insert(m, key, value, hash); \
+    return 1; \
+} \
+ \
+/* adds only if not existed. added = 1, existed = 0 */ \
+static inline int name##_tryadd(name##_t* m, K key, V value){ \
+    if(m == NULL) return 0; \
+    _##name##_maybe_expand(m); \
+    size_t hash = hash_fn(key); \
+    if(_##name##_find(m, key, hash) != m->cap) \
+        return 0; \
+    _##name##_insert(m, key, value, hash); \
+    return 1; \
+} \
+ \
+/* changes only if existed. changed = 1, not existed = 0 */ \
+static inline int name##_trychange(name##_t* m, K key, V value){ \
+    if(m == NULL || m->count == 0) return 0; \
+    size_t i = _##name##_find(m, key, hash_fn(key)); \
+    if(i == m->cap) \
+        return 0; \
+    m->slots[i].value = value; \
+    return 1; \
+} \
+ \
+/* exists = pointer to value inside map (valid until next insert), not exists = NULL */ \
+static inline V* name##_get(name##_t* m, K key){ \
+    if(m == NULL || m->count == 0) return NULL; \
+    size_t i = _##name##_find(m, key, hash_fn(key)); \
+    if(i == m->cap) \
+        return NULL; \
+    return &m->slots[i].value; \
+} \
+ \
+/* removed(existed) = 1 and value copied to out if not NULL, not exists = 0 */ \
+static inline int name##_remove(name##_t* m, K key, V* out){ \
+    if(m == NULL || m->count == 0) return 0; \
+    size_t i = _##name##_find(m, key, hash_fn(key)); \
+    if(i == m->cap) \
+        return 0; \
+    if(out) \
+        *out = m->slots[i].value; \
+    size_t mask = m->cap - 1; \
+    /* pull later entries of the run back into the hole unless that would put them before their home */ \
+    for(size_t j = (i + 1) & mask; m->ctrl[j]; j = (j + 1) & mask){ \
+        size_t home = hash_fn(m->slots[j].key) & mask; \
+        if(((j - home) & mask) < ((j - i) & mask)) \
+            continue; \
+        m->ctrl[i] = m->ctrl[j]; \
+        m->slots[i] = m->slots[j]; \
+        i = j; \
+    } \
+    m->ctrl[i] = 0; \
+    m->count--; \
+    return 1; \
+} \
+ \
+static inline void name##_clear(name##_t* m){ \
+    if(m == NULL) return; \
+    if(m->ctrl) \
+        memset(m->ctrl, 0, m->cap); \
+    m->count = 0; \
+} \
+ \
+static inline void name##_destroy(name##_t* m){ \
+    if(m == NULL) return; \
+    free(m->slots); \
+    free(m->ctrl); \
+    name##_init(m); \
+} \
+ \
+static inline name##_iter_t name##_iter(name##_t* m){ \
+    name##_iter_t it = {NULL, NULL, m, 0}; \
+    return it; \
+} \
+ \
+static inline int name##_iter_next(name##_iter_t* it){ \
+    if(it == NULL || it->_m == NULL) return 0; \
+    name##_t* m = it->_m; \
+    for(size_t i = it->_index; i < m->cap; i++){ \
+        if(m->ctrl[i]){ \
+            it->key = &m->slots[i].key; \
+            it->value = &m->slots[i].value; \
+            it->_index = i + 1; \
+            return 1; \
+        } \
+    } \
+    it->_index = m->cap; \
+    return 0; \
+}